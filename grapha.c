@@ -1,7 +1,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <uuid/uuid.h>
 
 // Assuming a robust hash map library with these function signatures.
@@ -14,66 +23,628 @@ extern void hashmap_remove(hashmap_t* map, const char* key);
 extern void hashmap_destroy(hashmap_t* map);
 extern void hashmap_free_values_and_destroy(hashmap_t* map); // For cleanup
 
-// A simple dynamic array (vector) for the adjacency lists
+// --- Slab Pools ---
+
+// Records and strings are bump-allocated from large slabs and released all at
+// once, so building and destroying a graph costs a few mallocs per slab
+// rather than several per vertex or edge.
+#define SLAB_SIZE (64 * 1024)
+
+typedef struct Slab {
+    struct Slab* next;
+    size_t used;
+    size_t capacity;
+    unsigned char data[];
+} Slab;
+
+typedef struct {
+    Slab* head;
+} SlabPool;
+
+void* slab_alloc(SlabPool* pool, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+    Slab* slab = pool->head;
+    if (slab == NULL || slab->capacity - slab->used < size) {
+        size_t capacity = size > SLAB_SIZE ? size : SLAB_SIZE;
+        slab = malloc(sizeof(Slab) + capacity);
+        slab->used = 0;
+        slab->capacity = capacity;
+        slab->next = pool->head;
+        pool->head = slab;
+    }
+    void* memory = slab->data + slab->used;
+    slab->used += size;
+    return memory;
+}
+
+char* slab_strdup(SlabPool* pool, const char* text) {
+    size_t length = strlen(text) + 1;
+    char* copy = slab_alloc(pool, length);
+    memcpy(copy, text, length);
+    return copy;
+}
+
+void slab_pool_free(SlabPool* pool) {
+    Slab* slab = pool->head;
+    while (slab != NULL) {
+        Slab* next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    pool->head = NULL;
+}
+
+// Arrays that grow one element at a time (adjacency lists, vertex labels)
+// take power-of-two blocks carved from slabs. When an array moves to a
+// bigger block its old one goes on a free list for that size and is handed
+// out again, so growth never calls free() and the whole pool is released
+// slab by slab.
+#define BLOCK_MIN_SHIFT 4
+#define BLOCK_CLASSES 40
+
+typedef struct {
+    SlabPool slabs;
+    void* free_blocks[BLOCK_CLASSES];  // Released blocks, linked through their first word
+} BlockPool;
+
+static unsigned block_class(size_t bytes) {
+    unsigned shift = BLOCK_MIN_SHIFT;
+    while (((size_t)1 << shift) < bytes) {
+        shift++;
+    }
+    return shift;
+}
+
+// Moves an array from its block of old_bytes (0 for none) into a block of at
+// least new_bytes, keeping its contents. old_bytes is the size the block was
+// requested with, not how much of it is in use: it picks the free list the
+// block goes back on. Returns the block unchanged when it is already big
+// enough.
+void* block_resize(BlockPool* pool, void* block, size_t old_bytes, size_t new_bytes) {
+    unsigned old_class = block_class(old_bytes);
+    unsigned new_class = block_class(new_bytes);
+    if (block != NULL && new_class <= old_class) {
+        return block;
+    }
+    void* grown = pool->free_blocks[new_class];
+    if (grown != NULL) {
+        pool->free_blocks[new_class] = *(void**)grown;
+    } else {
+        grown = slab_alloc(&pool->slabs, (size_t)1 << new_class);
+    }
+    if (block != NULL) {
+        memcpy(grown, block, old_bytes);
+        *(void**)block = pool->free_blocks[old_class];
+        pool->free_blocks[old_class] = block;
+    }
+    return grown;
+}
+
+void block_pool_free(BlockPool* pool) {
+    slab_pool_free(&pool->slabs);
+    memset(pool->free_blocks, 0, sizeof(pool->free_blocks));
+}
+
+// --- Interned Strings ---
+
+static uint32_t string_hash(const char* key) {
+    uint32_t hash = 2166136261u;
+    while (*key) {
+        hash ^= (unsigned char)*key++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Append-only table giving each distinct string a dense id
 typedef struct {
-    void** items;
+    char* data;           // NUL-terminated strings back to back
     size_t size;
     size_t capacity;
-} vector_t;
+    uint32_t* offsets;    // String id -> offset in data
+    uint32_t count;
+    uint32_t offsets_capacity;
+    uint32_t* slots;      // Open addressing: string id + 1, 0 when empty
+    uint32_t slot_capacity;
+    bool full;            // An intern was refused; see string_table_intern
+} StringTable;
+
+#define STRING_TABLE_FULL UINT32_MAX
+
+static const char* string_table_get(const StringTable* table, uint32_t id) {
+    return table->data + table->offsets[id];
+}
+
+static bool string_table_find(const StringTable* table, const char* key, uint32_t* id) {
+    if (table->slot_capacity == 0) {
+        return false;
+    }
+    uint32_t mask = table->slot_capacity - 1;
+    for (uint32_t slot = string_hash(key) & mask; table->slots[slot] != 0; slot = (slot + 1) & mask) {
+        uint32_t candidate = table->slots[slot] - 1;
+        if (strcmp(string_table_get(table, candidate), key) == 0) {
+            *id = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void string_table_rehash(StringTable* table, uint32_t slot_capacity) {
+    free(table->slots);
+    table->slots = calloc(slot_capacity, sizeof(uint32_t));
+    table->slot_capacity = slot_capacity;
+    uint32_t mask = slot_capacity - 1;
+    for (uint32_t id = 0; id < table->count; ++id) {
+        uint32_t slot = string_hash(string_table_get(table, id)) & mask;
+        while (table->slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        table->slots[slot] = id + 1;
+    }
+}
+
+// Returns the id of key, adding a copy of it if it is new. Offsets and slots
+// are 32-bit, so a new key that would take the text past 4 GiB or the slot
+// array past 2^31 entries is refused: the table is marked full and
+// STRING_TABLE_FULL is returned.
+static uint32_t string_table_intern(StringTable* table, const char* key) {
+    uint32_t id;
+    if (string_table_find(table, key, &id)) {
+        return id;
+    }
+    size_t length = strlen(key) + 1;
+    if (table->size + length > UINT32_MAX ||
+        (2 * ((uint64_t)table->count + 1) > table->slot_capacity && table->slot_capacity > UINT32_MAX / 2)) {
+        table->full = true;
+        return STRING_TABLE_FULL;
+    }
+    if (table->size + length > table->capacity) {
+        size_t capacity = table->capacity ? table->capacity * 2 : 4096;
+        while (capacity < table->size + length) {
+            capacity *= 2;
+        }
+        table->data = realloc(table->data, capacity);
+        table->capacity = capacity;
+    }
+    if (table->count == table->offsets_capacity) {
+        table->offsets_capacity = table->offsets_capacity ? table->offsets_capacity * 2 : 256;
+        table->offsets = realloc(table->offsets, table->offsets_capacity * sizeof(uint32_t));
+    }
+    memcpy(table->data + table->size, key, length);
+    id = table->count++;
+    table->offsets[id] = (uint32_t)table->size;
+    table->size += length;
+
+    if (2 * table->count > table->slot_capacity) {
+        string_table_rehash(table, table->slot_capacity ? table->slot_capacity * 2 : 512);
+    } else {
+        uint32_t mask = table->slot_capacity - 1;
+        uint32_t slot = string_hash(key) & mask;
+        while (table->slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        table->slots[slot] = id + 1;
+    }
+    return id;
+}
+
+static void string_table_free(StringTable* table) {
+    free(table->data);
+    free(table->offsets);
+    free(table->slots);
+}
+
+// --- Property Tables ---
+
+// Properties live in typed columns, one per key, indexed by the dense id of
+// the vertex or edge (its index field). A bitmap records which rows have a
+// value, so an unset property costs one bit rather than a hash map per
+// element. String values are interned in the graph's property string table.
+
+typedef enum {
+    PROPERTY_DOUBLE,
+    PROPERTY_INT64,
+    PROPERTY_BOOL,
+    PROPERTY_STRING
+} PropertyType;
+
+typedef struct {
+    char* key;
+    PropertyType type;
+    void* values;         // double, int64_t, bool or uint32_t string id per row
+    uint64_t* present;    // Bit row is set when row has a value
+    uint32_t capacity;    // Rows allocated in values and present
+} PropertyColumn;
+
+typedef struct {
+    PropertyColumn* columns;
+    uint32_t column_count;
+    uint32_t column_capacity;
+    StringTable* strings;
+} PropertyTable;
+
+static size_t property_type_size(PropertyType type) {
+    switch (type) {
+        case PROPERTY_DOUBLE: return sizeof(double);
+        case PROPERTY_INT64: return sizeof(int64_t);
+        case PROPERTY_BOOL: return sizeof(bool);
+        default: return sizeof(uint32_t);
+    }
+}
+
+PropertyColumn* property_table_find(const PropertyTable* table, const char* key) {
+    for (uint32_t i = 0; i < table->column_count; ++i) {
+        if (strcmp(table->columns[i].key, key) == 0) {
+            return &table->columns[i];
+        }
+    }
+    return NULL;
+}
+
+// Returns the column for key, creating it with type if it does not exist.
+// Returns NULL if key already holds another type.
+PropertyColumn* property_table_column(PropertyTable* table, const char* key, PropertyType type) {
+    PropertyColumn* column = property_table_find(table, key);
+    if (column) {
+        return column->type == type ? column : NULL;
+    }
+    if (table->column_count == table->column_capacity) {
+        table->column_capacity = table->column_capacity ? table->column_capacity * 2 : 4;
+        table->columns = realloc(table->columns, table->column_capacity * sizeof(PropertyColumn));
+    }
+    column = &table->columns[table->column_count++];
+    column->key = strdup(key);
+    column->type = type;
+    column->values = NULL;
+    column->present = NULL;
+    column->capacity = 0;
+    return column;
+}
+
+// Grows a column to cover row, zeroing the new values and bits
+static void property_column_reserve(PropertyColumn* column, uint32_t row) {
+    if (row < column->capacity) {
+        return;
+    }
+    uint32_t capacity = column->capacity ? column->capacity : 64;
+    while (capacity <= row) {
+        capacity *= 2;
+    }
+    size_t size = property_type_size(column->type);
+    column->values = realloc(column->values, capacity * size);
+    memset((char*)column->values + column->capacity * size, 0, (capacity - column->capacity) * size);
+    column->present = realloc(column->present, (capacity / 64) * sizeof(uint64_t));
+    memset(column->present + column->capacity / 64, 0, ((capacity - column->capacity) / 64) * sizeof(uint64_t));
+    column->capacity = capacity;
+}
+
+bool property_column_has(const PropertyColumn* column, uint32_t row) {
+    return row < column->capacity && (column->present[row / 64] >> (row % 64) & 1);
+}
+
+// Returns the slot for row in a column of type, marking it present, or NULL
+// on a type mismatch
+static void* property_slot(PropertyTable* table, uint32_t row, const char* key, PropertyType type) {
+    PropertyColumn* column = property_table_column(table, key, type);
+    if (!column) {
+        return NULL;
+    }
+    property_column_reserve(column, row);
+    column->present[row / 64] |= (uint64_t)1 << (row % 64);
+    return (char*)column->values + row * property_type_size(type);
+}
+
+// Returns the value slot for row if it is set with the given type
+static const void* property_value(const PropertyTable* table, uint32_t row, const char* key, PropertyType type) {
+    const PropertyColumn* column = property_table_find(table, key);
+    if (!column || column->type != type || !property_column_has(column, row)) {
+        return NULL;
+    }
+    return (const char*)column->values + row * property_type_size(type);
+}
+
+bool property_set_double(PropertyTable* table, uint32_t row, const char* key, double value) {
+    double* slot = property_slot(table, row, key, PROPERTY_DOUBLE);
+    return slot ? (*slot = value, true) : false;
+}
+
+bool property_set_int64(PropertyTable* table, uint32_t row, const char* key, int64_t value) {
+    int64_t* slot = property_slot(table, row, key, PROPERTY_INT64);
+    return slot ? (*slot = value, true) : false;
+}
+
+bool property_set_bool(PropertyTable* table, uint32_t row, const char* key, bool value) {
+    bool* slot = property_slot(table, row, key, PROPERTY_BOOL);
+    return slot ? (*slot = value, true) : false;
+}
+
+bool property_set_string(PropertyTable* table, uint32_t row, const char* key, const char* value) {
+    uint32_t id = string_table_intern(table->strings, value);
+    uint32_t* slot = id == STRING_TABLE_FULL ? NULL : property_slot(table, row, key, PROPERTY_STRING);
+    return slot ? (*slot = id, true) : false;
+}
+
+// Getters return false when the row has no value of that type under key
+bool property_get_double(const PropertyTable* table, uint32_t row, const char* key, double* value) {
+    const double* slot = property_value(table, row, key, PROPERTY_DOUBLE);
+    return slot ? (*value = *slot, true) : false;
+}
 
-vector_t* vector_create(size_t initial_capacity);
-void vector_push(vector_t* vec, void* item);
-void* vector_get(vector_t* vec, size_t index);
-void vector_remove(vector_t* vec, size_t index);
-void vector_free(vector_t* vec);
+bool property_get_int64(const PropertyTable* table, uint32_t row, const char* key, int64_t* value) {
+    const int64_t* slot = property_value(table, row, key, PROPERTY_INT64);
+    return slot ? (*value = *slot, true) : false;
+}
+
+bool property_get_bool(const PropertyTable* table, uint32_t row, const char* key, bool* value) {
+    const bool* slot = property_value(table, row, key, PROPERTY_BOOL);
+    return slot ? (*value = *slot, true) : false;
+}
+
+bool property_get_string(const PropertyTable* table, uint32_t row, const char* key, const char** value) {
+    const uint32_t* slot = property_value(table, row, key, PROPERTY_STRING);
+    return slot ? (*value = string_table_get(table->strings, *slot), true) : false;
+}
+
+void property_clear(PropertyTable* table, uint32_t row, const char* key) {
+    PropertyColumn* column = property_table_find(table, key);
+    if (column && row < column->capacity) {
+        column->present[row / 64] &= ~((uint64_t)1 << (row % 64));
+    }
+}
+
+static void property_table_free(PropertyTable* table) {
+    for (uint32_t i = 0; i < table->column_count; ++i) {
+        free(table->columns[i].key);
+        free(table->columns[i].values);
+        free(table->columns[i].present);
+    }
+    free(table->columns);
+}
+
+// --- Label Index ---
+
+// Labels are interned to dense ids. Each label keeps posting lists: sorted
+// arrays of the vertex and edge indices carrying it, so "everything with
+// label L" is a slice rather than a scan, and filters compare ids instead of
+// strings. Indices are handed out in increasing order, so inserts are
+// usually appends.
+
+#define GRAPH_NO_LABEL UINT32_MAX
+
+typedef struct {
+    uint32_t* ids;
+    uint32_t count;
+    uint32_t capacity;
+} PostingList;
+
+typedef struct {
+    PostingList vertices;
+    PostingList edges;
+} LabelPostings;
+
+// Returns the position of the first entry >= id
+static uint32_t posting_lower_bound(const PostingList* list, uint32_t id) {
+    uint32_t low = 0, high = list->count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (list->ids[mid] < id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+bool posting_contains(const PostingList* list, uint32_t id) {
+    uint32_t position = posting_lower_bound(list, id);
+    return position < list->count && list->ids[position] == id;
+}
+
+static void posting_insert(PostingList* list, uint32_t id) {
+    uint32_t position = list->count;
+    if (list->count > 0 && list->ids[list->count - 1] >= id) {
+        position = posting_lower_bound(list, id);
+        if (list->ids[position] == id) {
+            return;
+        }
+    }
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 8;
+        list->ids = realloc(list->ids, list->capacity * sizeof(uint32_t));
+    }
+    memmove(list->ids + position + 1, list->ids + position, (list->count - position) * sizeof(uint32_t));
+    list->ids[position] = id;
+    list->count++;
+}
+
+static void posting_remove(PostingList* list, uint32_t id) {
+    uint32_t position = posting_lower_bound(list, id);
+    if (position < list->count && list->ids[position] == id) {
+        list->count--;
+        memmove(list->ids + position, list->ids + position + 1, (list->count - position) * sizeof(uint32_t));
+    }
+}
 
 // --- Graph Structs ---
 
 typedef struct {
     char* id;
-    hashmap_t* properties;
-    vector_t* labels;
+    uint32_t index;        // Dense id: row in the vertex property table
+    uint32_t* labels;      // Sorted label ids, NULL until the first label
+    uint32_t label_count;
+    uint32_t label_capacity;
 } Vertex;
 
 typedef struct {
     char* id;
     char* source_id;
     char* target_id;
-    hashmap_t* properties;
-    char* label;
+    uint32_t index;        // Dense id: row in the edge property table
+    uint32_t label;        // Label id, or GRAPH_NO_LABEL
     bool directed;
 } Edge;
 
+// Edges incident to a vertex. The storage belongs to grapha.c rather than the
+// external vector library, so batch insertion can size it exactly; edges
+// lives in the graph's block pool.
+typedef struct {
+    Edge** edges;
+    uint32_t size;
+    uint32_t capacity;
+} AdjacencyList;
+
 typedef struct {
     hashmap_t* vertices; // Maps vertex_id (char*) to Vertex*
-    hashmap_t* adjacency_list; // Maps vertex_id (char*) to vector_t* of Edge*
+    hashmap_t* adjacency_list; // Maps vertex_id (char*) to AdjacencyList*
     bool is_directed;
     bool is_weighted;
+    SlabPool vertex_pool;
+    SlabPool edge_pool;
+    SlabPool string_pool;     // Vertex and edge ids
+    SlabPool list_pool;       // AdjacencyList headers
+    BlockPool array_pool;     // Adjacency and vertex label arrays
+    uint64_t next_edge_id;    // Counter for batch-inserted edge ids
+    uint32_t vertex_count;
+    uint32_t edge_count;
+    Vertex** vertex_table;    // Vertex by index
+    Edge** edge_table;        // Edge by index
+    uint32_t vertex_table_capacity;
+    uint32_t edge_table_capacity;
+    StringTable label_names;  // Label id -> label
+    LabelPostings* label_postings;
+    uint32_t label_postings_capacity;
+    PropertyTable vertex_properties;
+    PropertyTable edge_properties;  // Column 0 is "weight"
+    StringTable property_strings;
 } Graph;
 
 // --- Graph Function Definitions ---
 
+// Grows an adjacency list to hold at least capacity edges
+static void adjacency_reserve(BlockPool* pool, AdjacencyList* list, uint32_t capacity) {
+    if (list->capacity >= capacity) {
+        return;
+    }
+    uint32_t grown = list->capacity ? list->capacity : 8;
+    while (grown < capacity) {
+        grown *= 2;
+    }
+    list->edges = block_resize(pool, list->edges, list->capacity * sizeof(Edge*), grown * sizeof(Edge*));
+    list->capacity = grown;
+}
+
+static void adjacency_push(BlockPool* pool, AdjacencyList* list, Edge* edge) {
+    adjacency_reserve(pool, list, list->size + 1);
+    list->edges[list->size++] = edge;
+}
+
 Graph* graph_create() {
-    Graph* graph = malloc(sizeof(Graph));
+    Graph* graph = calloc(1, sizeof(Graph));
     graph->vertices = hashmap_create();
     graph->adjacency_list = hashmap_create();
     graph->is_directed = false;
     graph->is_weighted = false;
+    graph->vertex_properties.strings = &graph->property_strings;
+    graph->edge_properties.strings = &graph->property_strings;
+    property_table_column(&graph->edge_properties, "weight", PROPERTY_DOUBLE);
     return graph;
 }
 
+// Returns the id of label, interning it and giving it empty posting lists if
+// it is new, or GRAPH_NO_LABEL if the label table is full
+static uint32_t graph_intern_label(Graph* graph, const char* label) {
+    uint32_t id = string_table_intern(&graph->label_names, label);
+    if (id == STRING_TABLE_FULL) {
+        return GRAPH_NO_LABEL;
+    }
+    if (id == graph->label_postings_capacity) {
+        uint32_t capacity = graph->label_postings_capacity ? graph->label_postings_capacity * 2 : 16;
+        graph->label_postings = realloc(graph->label_postings, capacity * sizeof(LabelPostings));
+        memset(graph->label_postings + id, 0, (capacity - id) * sizeof(LabelPostings));
+        graph->label_postings_capacity = capacity;
+    }
+    return id;
+}
+
+// Looks a label up without interning it
+bool graph_label_id(const Graph* graph, const char* label, uint32_t* id) {
+    return string_table_find(&graph->label_names, label, id);
+}
+
+const char* graph_label_name(const Graph* graph, uint32_t id) {
+    return string_table_get(&graph->label_names, id);
+}
+
+const char* graph_edge_label(const Graph* graph, const Edge* edge) {
+    return edge->label == GRAPH_NO_LABEL ? NULL : graph_label_name(graph, edge->label);
+}
+
+// Relabels an edge; label may be NULL to remove it
+void graph_set_edge_label(Graph* graph, Edge* edge, const char* label) {
+    if (edge->label != GRAPH_NO_LABEL) {
+        posting_remove(&graph->label_postings[edge->label].edges, edge->index);
+    }
+    edge->label = label ? graph_intern_label(graph, label) : GRAPH_NO_LABEL;
+    if (edge->label != GRAPH_NO_LABEL) {
+        posting_insert(&graph->label_postings[edge->label].edges, edge->index);
+    }
+}
+
+// Gives a new edge the next dense id, records it in the edge table and the
+// label index, and stores its weight. Weight is column 0 of the edge table
+// and set on every edge, so weighted traversals read one contiguous array of
+// doubles.
+static void graph_register_edge(Graph* graph, Edge* edge, double weight, const char* label) {
+    edge->index = graph->edge_count++;
+    if (edge->index == graph->edge_table_capacity) {
+        graph->edge_table_capacity = graph->edge_table_capacity ? graph->edge_table_capacity * 2 : 256;
+        graph->edge_table = realloc(graph->edge_table, graph->edge_table_capacity * sizeof(Edge*));
+    }
+    graph->edge_table[edge->index] = edge;
+    edge->label = GRAPH_NO_LABEL;
+    graph_set_edge_label(graph, edge, label);
+    PropertyColumn* column = &graph->edge_properties.columns[0];
+    property_column_reserve(column, edge->index);
+    column->present[edge->index / 64] |= (uint64_t)1 << (edge->index % 64);
+    ((double*)column->values)[edge->index] = weight;
+}
+
+// Returns the weight column, indexed by Edge.index
+double* graph_edge_weights(const Graph* graph) {
+    return graph->edge_properties.columns[0].values;
+}
+
+double graph_edge_weight(const Graph* graph, const Edge* edge) {
+    return graph_edge_weights(graph)[edge->index];
+}
+
+void graph_set_edge_weight(Graph* graph, const Edge* edge, double weight) {
+    graph_edge_weights(graph)[edge->index] = weight;
+}
+
 void graph_add_vertex(Graph* graph, const char* vertex_id) {
     if (hashmap_get(graph->vertices, vertex_id) != NULL) {
         return; // Vertex already exists
     }
 
-    Vertex* new_vertex = malloc(sizeof(Vertex));
-    new_vertex->id = strdup(vertex_id);
-    new_vertex->properties = hashmap_create();
-    new_vertex->labels = vector_create(4);
+    Vertex* new_vertex = slab_alloc(&graph->vertex_pool, sizeof(Vertex));
+    new_vertex->id = slab_strdup(&graph->string_pool, vertex_id);
+    new_vertex->index = graph->vertex_count++;
+    new_vertex->labels = NULL;
+    new_vertex->label_count = 0;
+    new_vertex->label_capacity = 0;
+    if (new_vertex->index == graph->vertex_table_capacity) {
+        graph->vertex_table_capacity = graph->vertex_table_capacity ? graph->vertex_table_capacity * 2 : 256;
+        graph->vertex_table = realloc(graph->vertex_table, graph->vertex_table_capacity * sizeof(Vertex*));
+    }
+    graph->vertex_table[new_vertex->index] = new_vertex;
 
     hashmap_put(graph->vertices, new_vertex->id, new_vertex);
-    hashmap_put(graph->adjacency_list, new_vertex->id, vector_create(8));
+    AdjacencyList* adj_list = slab_alloc(&graph->list_pool, sizeof(AdjacencyList));
+    memset(adj_list, 0, sizeof(AdjacencyList));
+    hashmap_put(graph->adjacency_list, new_vertex->id, adj_list);
 }
 
 void graph_add_edge(Graph* graph, const char* source_id, const char* target_id, bool directed, double weight, const char* label) {
@@ -83,75 +654,1774 @@ void graph_add_edge(Graph* graph, const char* source_id, const char* target_id,
     }
 
     // Allocate and initialize new edge
-    Edge* new_edge = malloc(sizeof(Edge));
+    Edge* new_edge = slab_alloc(&graph->edge_pool, sizeof(Edge));
     uuid_t edge_uuid;
     uuid_generate_random(edge_uuid);
     char uuid_str[37];
     uuid_unparse_lower(edge_uuid, uuid_str);
-    new_edge->id = strdup(uuid_str);
-    new_edge->source_id = strdup(source_id);
-    new_edge->target_id = strdup(target_id);
-    new_edge->label = strdup(label);
+    new_edge->id = slab_strdup(&graph->string_pool, uuid_str);
+    new_edge->source_id = slab_strdup(&graph->string_pool, source_id);
+    new_edge->target_id = slab_strdup(&graph->string_pool, target_id);
     new_edge->directed = directed;
-    new_edge->properties = hashmap_create();
-    hashmap_put(new_edge->properties, "weight", &weight); // store weight in properties
+    graph_register_edge(graph, new_edge, weight, label);
 
     // Add to adjacency list of source
-    vector_t* source_adj = (vector_t*)hashmap_get(graph->adjacency_list, source_id);
-    vector_push(source_adj, new_edge);
+    AdjacencyList* source_adj = (AdjacencyList*)hashmap_get(graph->adjacency_list, source_id);
+    adjacency_push(&graph->array_pool, source_adj, new_edge);
 
-    // If undirected, add to adjacency list of target
-    if (!directed) {
-        Edge* reverse_edge = malloc(sizeof(Edge));
-        // Note: In a real implementation, you'd share the same Edge object
-        // with two different "views" to save memory.
-        *reverse_edge = *new_edge; // Shallow copy
-        reverse_edge->directed = false;
-        
-        vector_t* target_adj = (vector_t*)hashmap_get(graph->adjacency_list, target_id);
-        vector_push(target_adj, reverse_edge);
+    // If undirected, the target's adjacency list shares the same Edge object.
+    // graph_destroy frees it only from the source's list.
+    if (!directed && strcmp(source_id, target_id) != 0) {
+        AdjacencyList* target_adj = (AdjacencyList*)hashmap_get(graph->adjacency_list, target_id);
+        adjacency_push(&graph->array_pool, target_adj, new_edge);
     }
 }
 
-// Memory-safe destruction and cleanup
-void graph_destroy(Graph* graph) {
-    // First, free all edge vectors and their contents
-    vector_t* all_edges_to_free = vector_create(1);
+// --- Batch Insertion ---
+
+// One distinct endpoint of a batch, resolved against the graph once
+typedef struct {
     const char* key;
-    hashmap_foreach_key_start(graph->adjacency_list, key) {
-        vector_t* adj_list = (vector_t*)hashmap_get(graph->adjacency_list, key);
-        for (size_t i = 0; i < adj_list->size; ++i) {
-            Edge* edge = (Edge*)vector_get(adj_list, i);
-            // Only free the edge if it's the primary one (i.e., not a reverse edge)
-            if (strcmp(edge->source_id, key) == 0) {
-                vector_push(all_edges_to_free, edge);
+    Vertex* vertex;       // NULL when the vertex does not exist
+    AdjacencyList* adjacency;
+    size_t pending;       // Adjacency entries this batch will add
+} BatchEndpoint;
+
+static size_t batch_endpoint_slot(BatchEndpoint* table, size_t mask, const char* key) {
+    size_t slot = string_hash(key) & mask;
+    while (table[slot].key != NULL && strcmp(table[slot].key, key) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    table[slot].key = key;
+    return slot;
+}
+
+// Adds count edges at once. weights and labels may be NULL (weight 1.0, no
+// label). Each distinct endpoint is looked up once, adjacency lists are grown
+// once to their final size, and edge ids come from a per-graph counter
+// ("e<n>") unless use_uuids is set. Edges whose endpoints do not exist are
+// skipped. Returns the number of edges added.
+size_t graph_add_edges_batch(Graph* graph, const char** source_ids, const char** target_ids, const double* weights,
+                             const char** labels, size_t count, bool directed, bool use_uuids) {
+    size_t table_size = 16;
+    while (table_size < 4 * count) {
+        table_size *= 2;
+    }
+    size_t mask = table_size - 1;
+    BatchEndpoint* table = calloc(table_size, sizeof(BatchEndpoint));
+    size_t* source_slots = malloc((count + 1) * sizeof(size_t));
+    size_t* target_slots = malloc((count + 1) * sizeof(size_t));
+
+    for (size_t i = 0; i < count; ++i) {
+        source_slots[i] = batch_endpoint_slot(table, mask, source_ids[i]);
+        target_slots[i] = batch_endpoint_slot(table, mask, target_ids[i]);
+    }
+    for (size_t slot = 0; slot < table_size; ++slot) {
+        if (table[slot].key != NULL) {
+            table[slot].vertex = (Vertex*)hashmap_get(graph->vertices, table[slot].key);
+            if (table[slot].vertex != NULL) {
+                table[slot].adjacency = (AdjacencyList*)hashmap_get(graph->adjacency_list, table[slot].key);
             }
         }
-        vector_free(adj_list);
-    } hashmap_foreach_key_end();
+    }
 
-    for(size_t i = 0; i < all_edges_to_free->size; ++i) {
-        Edge* edge = (Edge*)vector_get(all_edges_to_free, i);
-        free(edge->id);
-        free(edge->source_id);
-        free(edge->target_id);
-        free(edge->label);
-        hashmap_destroy(edge->properties);
-        free(edge);
+    // Counting pass, then size every touched adjacency list once
+    for (size_t i = 0; i < count; ++i) {
+        BatchEndpoint* source = &table[source_slots[i]];
+        BatchEndpoint* target = &table[target_slots[i]];
+        if (source->vertex == NULL || target->vertex == NULL) {
+            continue;
+        }
+        source->pending++;
+        if (!directed && source != target) {
+            target->pending++;
+        }
+    }
+    for (size_t slot = 0; slot < table_size; ++slot) {
+        if (table[slot].pending > 0) {
+            adjacency_reserve(&graph->array_pool, table[slot].adjacency, table[slot].adjacency->size + (uint32_t)table[slot].pending);
+        }
     }
-    vector_free(all_edges_to_free);
 
-    // Then, free all vertices and their properties
-    hashmap_foreach_key_start(graph->vertices, key) {
-        Vertex* vertex = (Vertex*)hashmap_get(graph->vertices, key);
-        free(vertex->id);
-        hashmap_destroy(vertex->properties);
-        vector_free(vertex->labels);
-        free(vertex);
-    } hashmap_foreach_key_end();
+    size_t added = 0;
+    for (size_t i = 0; i < count; ++i) {
+        BatchEndpoint* source = &table[source_slots[i]];
+        BatchEndpoint* target = &table[target_slots[i]];
+        if (source->vertex == NULL || target->vertex == NULL) {
+            continue;
+        }
+        Edge* new_edge = slab_alloc(&graph->edge_pool, sizeof(Edge));
+        char id[37];
+        if (use_uuids) {
+            uuid_t edge_uuid;
+            uuid_generate_random(edge_uuid);
+            uuid_unparse_lower(edge_uuid, id);
+        } else {
+            snprintf(id, sizeof(id), "e%llu", (unsigned long long)graph->next_edge_id++);
+        }
+        new_edge->id = slab_strdup(&graph->string_pool, id);
+        // Endpoint strings are shared with the vertices; both live in the pool
+        new_edge->source_id = source->vertex->id;
+        new_edge->target_id = target->vertex->id;
+        new_edge->directed = directed;
+        graph_register_edge(graph, new_edge, weights ? weights[i] : 1.0, labels ? labels[i] : NULL);
+
+        adjacency_push(&graph->array_pool, source->adjacency, new_edge);
+        if (!directed && source != target) {
+            adjacency_push(&graph->array_pool, target->adjacency, new_edge);
+        }
+        added++;
+    }
+
+    free(table);
+    free(source_slots);
+    free(target_slots);
+    return added;
+}
+
+Vertex* graph_vertex_at(const Graph* graph, uint32_t index) {
+    return graph->vertex_table[index];
+}
+
+Edge* graph_edge_at(const Graph* graph, uint32_t index) {
+    return graph->edge_table[index];
+}
+
+// Position of label in a vertex's sorted label ids. Vertices carry a handful
+// of labels, so a linear scan is enough.
+static uint32_t vertex_label_position(const Vertex* vertex, uint32_t label) {
+    uint32_t position = 0;
+    while (position < vertex->label_count && vertex->labels[position] < label) {
+        position++;
+    }
+    return position;
+}
+
+bool graph_vertex_has_label(const Vertex* vertex, uint32_t label) {
+    uint32_t position = vertex_label_position(vertex, label);
+    return position < vertex->label_count && vertex->labels[position] == label;
+}
+
+void graph_vertex_add_label(Graph* graph, Vertex* vertex, const char* label) {
+    uint32_t id = graph_intern_label(graph, label);
+    if (id == GRAPH_NO_LABEL) {
+        return;
+    }
+    uint32_t position = vertex_label_position(vertex, id);
+    if (position < vertex->label_count && vertex->labels[position] == id) {
+        return;
+    }
+    if (vertex->label_count == vertex->label_capacity) {
+        uint32_t capacity = vertex->label_capacity ? vertex->label_capacity * 2 : 4;
+        vertex->labels = block_resize(&graph->array_pool, vertex->labels, vertex->label_capacity * sizeof(uint32_t),
+                                      capacity * sizeof(uint32_t));
+        vertex->label_capacity = capacity;
+    }
+    memmove(vertex->labels + position + 1, vertex->labels + position, (vertex->label_count - position) * sizeof(uint32_t));
+    vertex->labels[position] = id;
+    vertex->label_count++;
+    posting_insert(&graph->label_postings[id].vertices, vertex->index);
+}
+
+void graph_vertex_remove_label(Graph* graph, Vertex* vertex, const char* label) {
+    uint32_t id;
+    if (!graph_label_id(graph, label, &id) || !graph_vertex_has_label(vertex, id)) {
+        return;
+    }
+    uint32_t position = vertex_label_position(vertex, id);
+    vertex->label_count--;
+    memmove(vertex->labels + position, vertex->labels + position + 1, (vertex->label_count - position) * sizeof(uint32_t));
+    posting_remove(&graph->label_postings[id].vertices, vertex->index);
+}
+
+// Sorted indices of the vertices or edges carrying label; feed them to
+// graph_vertex_at / graph_edge_at. An unknown label yields an empty list.
+const uint32_t* graph_vertices_with_label(const Graph* graph, const char* label, uint32_t* count) {
+    uint32_t id;
+    if (!graph_label_id(graph, label, &id)) {
+        *count = 0;
+        return NULL;
+    }
+    *count = graph->label_postings[id].vertices.count;
+    return graph->label_postings[id].vertices.ids;
+}
+
+const uint32_t* graph_edges_with_label(const Graph* graph, const char* label, uint32_t* count) {
+    uint32_t id;
+    if (!graph_label_id(graph, label, &id)) {
+        *count = 0;
+        return NULL;
+    }
+    *count = graph->label_postings[id].edges.count;
+    return graph->label_postings[id].edges.ids;
+}
+
+// Collects up to max edges of vertex_id's adjacency list that carry label.
+// The label is resolved once; each entry is then an integer compare. Returns
+// the number of matching edges, which may exceed max.
+size_t graph_labeled_edges(const Graph* graph, const char* vertex_id, const char* label, Edge** edges, size_t max) {
+    uint32_t id;
+    AdjacencyList* adj_list = (AdjacencyList*)hashmap_get(graph->adjacency_list, vertex_id);
+    if (adj_list == NULL || !graph_label_id(graph, label, &id)) {
+        return 0;
+    }
+    size_t found = 0;
+    for (size_t i = 0; i < adj_list->size; ++i) {
+        Edge* edge = adj_list->edges[i];
+        if (edge->label == id) {
+            if (found < max) {
+                edges[found] = edge;
+            }
+            found++;
+        }
+    }
+    return found;
+}
+
+// Memory-safe destruction and cleanup. Vertex and Edge records, their
+// strings, adjacency lists and label arrays all live in slabs, so teardown
+// frees a handful of blocks per slab, label and property column. Nothing
+// here visits individual vertices or edges; only the external hash maps
+// may do so inside hashmap_destroy.
+void graph_destroy(Graph* graph) {
+    for (uint32_t id = 0; id < graph->label_names.count; ++id) {
+        free(graph->label_postings[id].vertices.ids);
+        free(graph->label_postings[id].edges.ids);
+    }
+    free(graph->label_postings);
+    string_table_free(&graph->label_names);
+    free(graph->vertex_table);
+    free(graph->edge_table);
+    property_table_free(&graph->vertex_properties);
+    property_table_free(&graph->edge_properties);
+    string_table_free(&graph->property_strings);
 
-    // Finally, free the hash maps themselves
+    // The hash maps are keyed by vertex ids from the string pool, so they go
+    // before the slabs
     hashmap_destroy(graph->vertices);
     hashmap_destroy(graph->adjacency_list);
+    slab_pool_free(&graph->vertex_pool);
+    slab_pool_free(&graph->edge_pool);
+    slab_pool_free(&graph->string_pool);
+    slab_pool_free(&graph->list_pool);
+    block_pool_free(&graph->array_pool);
     free(graph);
 }
+
+// --- Frozen Graph ---
+
+// Read-optimized snapshot of a Graph. Vertices get dense ids 0..vertex_count-1
+// and adjacency is stored in CSR form, so traversals only index arrays.
+// An undirected edge is one record that appears in both endpoints' rows.
+// Property columns and label postings are re-keyed to the frozen ids: row v
+// of a vertex column is vertex v, row e of an edge column is edge record e.
+
+#define FROZEN_NO_LABEL UINT32_MAX
+
+typedef struct {
+    uint32_t source;
+    uint32_t target;
+    double weight;
+    uint32_t label;       // String id, or FROZEN_NO_LABEL
+    bool directed;
+} FrozenEdge;
+
+typedef struct {
+    StringTable strings;  // Vertex v's id is string v; labels follow
+    uint32_t vertex_count;
+    uint32_t edge_count;  // Edge records
+    uint32_t slot_count;  // Adjacency entries
+    uint32_t* offsets;    // vertex_count + 1 offsets into the slot arrays
+    uint32_t* targets;    // Neighbour at each slot
+    double* weights;      // Weight at each slot
+    uint32_t* slot_edge;  // Edge record at each slot
+    FrozenEdge* edges;
+    uint32_t label_count;
+    uint32_t* label_ids;              // String id of each label
+    uint32_t* vertex_label_offsets;   // label_count + 1 offsets into vertex_label_postings
+    uint32_t* vertex_label_postings;  // Sorted vertices carrying each label
+    uint32_t* edge_label_offsets;     // label_count + 1 offsets into edge_label_postings
+    uint32_t* edge_label_postings;    // Sorted edge records carrying each label
+    PropertyTable vertex_properties;  // Columns cover all vertex_count rows
+    PropertyTable edge_properties;    // Columns cover all edge_count rows
+    bool is_directed;
+    bool is_weighted;
+    void* mapping;        // Snapshot the arrays point into, or NULL if owned
+    size_t mapping_size;
+} FrozenGraph;
+
+// Small open-addressing map from Edge* to its record index, used while freezing
+typedef struct {
+    const Edge** keys;
+    uint32_t* values;
+    size_t capacity;
+} EdgeIndexMap;
+
+static size_t pointer_hash(const void* pointer, size_t mask) {
+    uint64_t key = (uint64_t)(uintptr_t)pointer;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key & mask;
+}
+
+static uint32_t* edge_index_slot(EdgeIndexMap* map, const Edge* edge) {
+    size_t mask = map->capacity - 1;
+    size_t slot = pointer_hash(edge, mask);
+    while (map->keys[slot] != NULL && map->keys[slot] != edge) {
+        slot = (slot + 1) & mask;
+    }
+    map->keys[slot] = edge;
+    return &map->values[slot];
+}
+
+static int frozen_compare_ids(const void* a, const void* b) {
+    uint32_t left = *(const uint32_t*)a, right = *(const uint32_t*)b;
+    return (left > right) - (left < right);
+}
+
+// Builds the label posting lists. Edge postings come from the records'
+// labels; vertex postings from graph's label index, translated by
+// vertex_row (Graph index -> frozen id). graph is NULL for imported graphs,
+// whose vertices carry no labels. Labels are numbered by first use.
+static void frozen_index_labels(FrozenGraph* frozen, const Graph* graph, const uint32_t* vertex_row) {
+    // Intern vertex label names first, the string table may still grow
+    uint32_t graph_labels = graph ? graph->label_names.count : 0;
+    uint32_t* vertex_label_string = malloc((graph_labels + 1) * sizeof(uint32_t));
+    for (uint32_t id = 0; id < graph_labels; ++id) {
+        vertex_label_string[id] = graph->label_postings[id].vertices.count == 0
+                                      ? FROZEN_NO_LABEL
+                                      : string_table_intern(&frozen->strings, graph_label_name(graph, id));
+    }
+    uint32_t* label_of = malloc((frozen->strings.count + 1) * sizeof(uint32_t));
+    memset(label_of, 0xff, (frozen->strings.count + 1) * sizeof(uint32_t));
+    uint32_t label_count = 0;
+    for (uint32_t e = 0; e < frozen->edge_count; ++e) {
+        uint32_t label = frozen->edges[e].label;
+        if (label != FROZEN_NO_LABEL && label_of[label] == FROZEN_NO_LABEL) {
+            label_of[label] = label_count++;
+        }
+    }
+    for (uint32_t id = 0; id < graph_labels; ++id) {
+        uint32_t label = vertex_label_string[id];
+        if (label != FROZEN_NO_LABEL && label_of[label] == FROZEN_NO_LABEL) {
+            label_of[label] = label_count++;
+        }
+    }
+    frozen->label_count = label_count;
+    frozen->label_ids = malloc((label_count + 1) * sizeof(uint32_t));
+    for (uint32_t string = 0; string < frozen->strings.count; ++string) {
+        if (label_of[string] != FROZEN_NO_LABEL) {
+            frozen->label_ids[label_of[string]] = string;
+        }
+    }
+
+    // Edge records are visited in order, so each list comes out sorted
+    frozen->edge_label_offsets = calloc(label_count + 1, sizeof(uint32_t));
+    for (uint32_t e = 0; e < frozen->edge_count; ++e) {
+        if (frozen->edges[e].label != FROZEN_NO_LABEL) {
+            frozen->edge_label_offsets[label_of[frozen->edges[e].label] + 1]++;
+        }
+    }
+    for (uint32_t label = 0; label < label_count; ++label) {
+        frozen->edge_label_offsets[label + 1] += frozen->edge_label_offsets[label];
+    }
+    frozen->edge_label_postings = malloc((frozen->edge_label_offsets[label_count] + 1) * sizeof(uint32_t));
+    uint32_t* cursors = malloc((label_count + 1) * sizeof(uint32_t));
+    memcpy(cursors, frozen->edge_label_offsets, (label_count + 1) * sizeof(uint32_t));
+    for (uint32_t e = 0; e < frozen->edge_count; ++e) {
+        if (frozen->edges[e].label != FROZEN_NO_LABEL) {
+            frozen->edge_label_postings[cursors[label_of[frozen->edges[e].label]]++] = e;
+        }
+    }
+
+    frozen->vertex_label_offsets = calloc(label_count + 1, sizeof(uint32_t));
+    for (uint32_t id = 0; id < graph_labels; ++id) {
+        if (vertex_label_string[id] != FROZEN_NO_LABEL) {
+            frozen->vertex_label_offsets[label_of[vertex_label_string[id]] + 1] = graph->label_postings[id].vertices.count;
+        }
+    }
+    for (uint32_t label = 0; label < label_count; ++label) {
+        frozen->vertex_label_offsets[label + 1] += frozen->vertex_label_offsets[label];
+    }
+    frozen->vertex_label_postings = malloc((frozen->vertex_label_offsets[label_count] + 1) * sizeof(uint32_t));
+    for (uint32_t id = 0; id < graph_labels; ++id) {
+        if (vertex_label_string[id] == FROZEN_NO_LABEL) {
+            continue;
+        }
+        const PostingList* list = &graph->label_postings[id].vertices;
+        uint32_t* postings = frozen->vertex_label_postings + frozen->vertex_label_offsets[label_of[vertex_label_string[id]]];
+        for (uint32_t i = 0; i < list->count; ++i) {
+            postings[i] = vertex_row[list->ids[i]];
+        }
+        qsort(postings, list->count, sizeof(uint32_t), frozen_compare_ids);
+    }
+    free(cursors);
+    free(label_of);
+    free(vertex_label_string);
+}
+
+// Copies the columns of a Graph property table into table, moving row r to
+// row_map[r] (rows mapping to UINT32_MAX are dropped). The columns cover
+// row_count rows. Keys and string values are interned in the frozen string
+// table, so snapshots can refer to them by id.
+static void frozen_copy_properties(FrozenGraph* frozen, PropertyTable* table, const PropertyTable* source,
+                                   const uint32_t* row_map, uint32_t source_rows, uint32_t row_count) {
+    table->strings = &frozen->strings;
+    for (uint32_t i = 0; i < source->column_count; ++i) {
+        const PropertyColumn* from = &source->columns[i];
+        string_table_intern(&frozen->strings, from->key);
+        PropertyColumn* column = property_table_column(table, from->key, from->type);
+        size_t size = property_type_size(from->type);
+        column->values = calloc((size_t)row_count + 1, size);
+        column->present = calloc(row_count / 64 + 1, sizeof(uint64_t));
+        column->capacity = row_count;
+        uint32_t rows = from->capacity < source_rows ? from->capacity : source_rows;
+        for (uint32_t row = 0; row < rows; ++row) {
+            uint32_t to = row_map[row];
+            if (to == UINT32_MAX || !property_column_has(from, row)) {
+                continue;
+            }
+            void* slot = (char*)column->values + (size_t)to * size;
+            if (from->type == PROPERTY_STRING) {
+                const char* value = string_table_get(source->strings, ((const uint32_t*)from->values)[row]);
+                *(uint32_t*)slot = string_table_intern(&frozen->strings, value);
+            } else {
+                memcpy(slot, (const char*)from->values + (size_t)row * size, size);
+            }
+            column->present[to / 64] |= (uint64_t)1 << (to % 64);
+        }
+    }
+}
+
+void frozen_graph_destroy(FrozenGraph* frozen) {
+    if (frozen->mapping) {
+        // Only the column descriptors live outside the mapping
+        free(frozen->vertex_properties.columns);
+        free(frozen->edge_properties.columns);
+        munmap(frozen->mapping, frozen->mapping_size);
+        free(frozen);
+        return;
+    }
+    string_table_free(&frozen->strings);
+    free(frozen->offsets);
+    free(frozen->targets);
+    free(frozen->weights);
+    free(frozen->slot_edge);
+    free(frozen->edges);
+    free(frozen->label_ids);
+    free(frozen->vertex_label_offsets);
+    free(frozen->vertex_label_postings);
+    free(frozen->edge_label_offsets);
+    free(frozen->edge_label_postings);
+    property_table_free(&frozen->vertex_properties);
+    property_table_free(&frozen->edge_properties);
+    free(frozen);
+}
+
+// Builds the frozen form of graph. The Graph is not modified and may be
+// destroyed afterwards. Returns NULL if the ids, labels and property strings
+// do not fit in one string table.
+FrozenGraph* graph_freeze(Graph* graph) {
+    FrozenGraph* frozen = calloc(1, sizeof(FrozenGraph));
+    frozen->is_directed = graph->is_directed;
+    frozen->is_weighted = graph->is_weighted;
+
+    // Dense vertex ids come first in the string table
+    const char* key;
+    hashmap_foreach_key_start(graph->vertices, key) {
+        string_table_intern(&frozen->strings, key);
+    } hashmap_foreach_key_end();
+    frozen->vertex_count = frozen->strings.count;
+    if (frozen->strings.full) {
+        frozen_graph_destroy(frozen);
+        return NULL;
+    }
+
+    // Count adjacency entries per vertex and edge records. An edge is owned by
+    // its source's list, as in graph_destroy.
+    frozen->offsets = calloc(frozen->vertex_count + 1, sizeof(uint32_t));
+    hashmap_foreach_key_start(graph->adjacency_list, key) {
+        AdjacencyList* adj_list = (AdjacencyList*)hashmap_get(graph->adjacency_list, key);
+        uint32_t vertex;
+        string_table_find(&frozen->strings, key, &vertex);
+        frozen->offsets[vertex + 1] = (uint32_t)adj_list->size;
+        frozen->slot_count += (uint32_t)adj_list->size;
+        for (size_t i = 0; i < adj_list->size; ++i) {
+            Edge* edge = adj_list->edges[i];
+            if (strcmp(edge->source_id, key) == 0) {
+                frozen->edge_count++;
+            }
+        }
+    } hashmap_foreach_key_end();
+    for (uint32_t v = 0; v < frozen->vertex_count; ++v) {
+        frozen->offsets[v + 1] += frozen->offsets[v];
+    }
+
+    frozen->targets = malloc((frozen->slot_count + 1) * sizeof(uint32_t));
+    frozen->weights = malloc((frozen->slot_count + 1) * sizeof(double));
+    frozen->slot_edge = malloc((frozen->slot_count + 1) * sizeof(uint32_t));
+    // Zeroed so the padding inside each record is written out as zeros
+    frozen->edges = calloc(frozen->edge_count + 1, sizeof(FrozenEdge));
+    uint32_t* edge_row = malloc(((size_t)graph->edge_count + 1) * sizeof(uint32_t));
+    memset(edge_row, 0xff, ((size_t)graph->edge_count + 1) * sizeof(uint32_t));
+
+    EdgeIndexMap edge_index;
+    edge_index.capacity = 16;
+    while (edge_index.capacity < 2 * (size_t)frozen->edge_count) {
+        edge_index.capacity *= 2;
+    }
+    edge_index.keys = calloc(edge_index.capacity, sizeof(Edge*));
+    edge_index.values = malloc(edge_index.capacity * sizeof(uint32_t));
+
+    // Edge records in the order their owning rows are visited
+    uint32_t record = 0;
+    hashmap_foreach_key_start(graph->adjacency_list, key) {
+        AdjacencyList* adj_list = (AdjacencyList*)hashmap_get(graph->adjacency_list, key);
+        for (size_t i = 0; i < adj_list->size; ++i) {
+            Edge* edge = adj_list->edges[i];
+            if (strcmp(edge->source_id, key) != 0) {
+                continue;
+            }
+            FrozenEdge* frozen_edge = &frozen->edges[record];
+            string_table_find(&frozen->strings, edge->source_id, &frozen_edge->source);
+            string_table_find(&frozen->strings, edge->target_id, &frozen_edge->target);
+            frozen_edge->weight = graph_edge_weight(graph, edge);
+            frozen_edge->label = edge->label == GRAPH_NO_LABEL ? FROZEN_NO_LABEL
+                                                              : string_table_intern(&frozen->strings, graph_label_name(graph, edge->label));
+            frozen_edge->directed = edge->directed;
+            edge_row[edge->index] = record;
+            *edge_index_slot(&edge_index, edge) = record++;
+        }
+    } hashmap_foreach_key_end();
+
+    // Fill each row in adjacency-list order
+    hashmap_foreach_key_start(graph->adjacency_list, key) {
+        AdjacencyList* adj_list = (AdjacencyList*)hashmap_get(graph->adjacency_list, key);
+        uint32_t vertex;
+        string_table_find(&frozen->strings, key, &vertex);
+        uint32_t slot = frozen->offsets[vertex];
+        for (size_t i = 0; i < adj_list->size; ++i, ++slot) {
+            uint32_t edge_record = *edge_index_slot(&edge_index, adj_list->edges[i]);
+            const FrozenEdge* frozen_edge = &frozen->edges[edge_record];
+            frozen->targets[slot] = (frozen_edge->source == vertex) ? frozen_edge->target : frozen_edge->source;
+            frozen->weights[slot] = frozen_edge->weight;
+            frozen->slot_edge[slot] = edge_record;
+        }
+    } hashmap_foreach_key_end();
+
+    free(edge_index.keys);
+    free(edge_index.values);
+
+    uint32_t* vertex_row = malloc(((size_t)graph->vertex_count + 1) * sizeof(uint32_t));
+    for (uint32_t index = 0; index < graph->vertex_count; ++index) {
+        string_table_find(&frozen->strings, graph->vertex_table[index]->id, &vertex_row[index]);
+    }
+    frozen_index_labels(frozen, graph, vertex_row);
+    frozen_copy_properties(frozen, &frozen->vertex_properties, &graph->vertex_properties, vertex_row,
+                           graph->vertex_count, frozen->vertex_count);
+    frozen_copy_properties(frozen, &frozen->edge_properties, &graph->edge_properties, edge_row, graph->edge_count,
+                           frozen->edge_count);
+    free(vertex_row);
+    free(edge_row);
+    // A label or property string that did not fit was stored as a sentinel
+    if (frozen->strings.full) {
+        frozen_graph_destroy(frozen);
+        return NULL;
+    }
+    return frozen;
+}
+
+// Translates a vertex id string to its dense id; the only lookup that hashes
+bool frozen_graph_find_vertex(const FrozenGraph* frozen, const char* vertex_id, uint32_t* vertex) {
+    uint32_t id;
+    if (!string_table_find(&frozen->strings, vertex_id, &id) || id >= frozen->vertex_count) {
+        return false;
+    }
+    *vertex = id;
+    return true;
+}
+
+const char* frozen_graph_vertex_id(const FrozenGraph* frozen, uint32_t vertex) {
+    return string_table_get(&frozen->strings, vertex);
+}
+
+const char* frozen_graph_edge_label(const FrozenGraph* frozen, uint32_t edge) {
+    uint32_t label = frozen->edges[edge].label;
+    return label == FROZEN_NO_LABEL ? NULL : string_table_get(&frozen->strings, label);
+}
+
+uint32_t frozen_graph_degree(const FrozenGraph* frozen, uint32_t vertex) {
+    return frozen->offsets[vertex + 1] - frozen->offsets[vertex];
+}
+
+// Neighbours of vertex; the matching weights and edge records are at the same
+// positions of frozen->weights and frozen->slot_edge
+const uint32_t* frozen_graph_neighbors(const FrozenGraph* frozen, uint32_t vertex, uint32_t* count) {
+    *count = frozen_graph_degree(frozen, vertex);
+    return frozen->targets + frozen->offsets[vertex];
+}
+
+// Looks up the id edges labelled label carry. Labels share the string table
+// with vertex ids, so a label spelled like a vertex id has that id.
+bool frozen_graph_label_id(const FrozenGraph* frozen, const char* label, uint32_t* id) {
+    return string_table_find(&frozen->strings, label, id);
+}
+
+// Sorted vertices or edge records carrying label, as graph_vertices_with_label
+// does for a Graph. Labels are few, so finding one is a linear scan.
+static const uint32_t* frozen_label_postings(const FrozenGraph* frozen, const char* label, const uint32_t* offsets,
+                                             const uint32_t* postings, uint32_t* count) {
+    uint32_t id;
+    *count = 0;
+    if (!frozen_graph_label_id(frozen, label, &id)) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < frozen->label_count; ++i) {
+        if (frozen->label_ids[i] == id) {
+            *count = offsets[i + 1] - offsets[i];
+            return postings + offsets[i];
+        }
+    }
+    return NULL;
+}
+
+const uint32_t* frozen_graph_vertices_with_label(const FrozenGraph* frozen, const char* label, uint32_t* count) {
+    return frozen_label_postings(frozen, label, frozen->vertex_label_offsets, frozen->vertex_label_postings, count);
+}
+
+const uint32_t* frozen_graph_edges_with_label(const FrozenGraph* frozen, const char* label, uint32_t* count) {
+    return frozen_label_postings(frozen, label, frozen->edge_label_offsets, frozen->edge_label_postings, count);
+}
+
+// Shared by frozen_graph_bfs and frozen_graph_bfs_labeled. When filtered,
+// only slots whose edge record carries label are followed.
+static uint32_t frozen_bfs(const FrozenGraph* frozen, uint32_t source, bool filtered, uint32_t label, uint32_t* order,
+                           int32_t* distance) {
+    int32_t* hops = distance ? distance : malloc((frozen->vertex_count + 1) * sizeof(int32_t));
+    for (uint32_t v = 0; v < frozen->vertex_count; ++v) {
+        hops[v] = -1;
+    }
+    uint32_t head = 0, tail = 0;
+    hops[source] = 0;
+    order[tail++] = source;
+    while (head < tail) {
+        uint32_t vertex = order[head++];
+        for (uint32_t slot = frozen->offsets[vertex]; slot < frozen->offsets[vertex + 1]; ++slot) {
+            if (filtered && frozen->edges[frozen->slot_edge[slot]].label != label) {
+                continue;
+            }
+            uint32_t next = frozen->targets[slot];
+            if (hops[next] < 0) {
+                hops[next] = hops[vertex] + 1;
+                order[tail++] = next;
+            }
+        }
+    }
+    if (!distance) {
+        free(hops);
+    }
+    return tail;
+}
+
+// Breadth-first search from source. Writes the visit order to order (room
+// for vertex_count entries) and, if distance is not NULL, the hop count of
+// every vertex (-1 when unreachable). Returns the number of vertices visited.
+uint32_t frozen_graph_bfs(const FrozenGraph* frozen, uint32_t source, uint32_t* order, int32_t* distance) {
+    return frozen_bfs(frozen, source, false, 0, order, distance);
+}
+
+// As frozen_graph_bfs, following only edges labelled label (an id from
+// frozen_graph_label_id)
+uint32_t frozen_graph_bfs_labeled(const FrozenGraph* frozen, uint32_t source, uint32_t label, uint32_t* order,
+                                  int32_t* distance) {
+    return frozen_bfs(frozen, source, true, label, order, distance);
+}
+
+// --- Snapshots ---
+
+// On-disk form of a FrozenGraph: a header, a table of sections, then the
+// sections themselves, each starting on a SNAPSHOT_ALIGNMENT boundary so
+// graph_load_mmap() can point the FrozenGraph arrays straight into the
+// mapping. Every section carries a checksum of its bytes; the header's
+// checksum covers the header and the section table. Arrays are stored in
+// native byte order, which the header records. The fixed sections are
+// followed by a values and a presence section per property column, vertex
+// columns first.
+
+#define SNAPSHOT_MAGIC "GRAPHASN"
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+#define SNAPSHOT_ALIGNMENT 64
+
+typedef enum {
+    SECTION_STRING_DATA,
+    SECTION_STRING_OFFSETS,
+    SECTION_STRING_SLOTS,
+    SECTION_OFFSETS,
+    SECTION_TARGETS,
+    SECTION_WEIGHTS,
+    SECTION_SLOT_EDGE,
+    SECTION_EDGES,        // FrozenEdge records: the per-edge property block
+    SECTION_LABEL_IDS,
+    SECTION_VERTEX_LABEL_OFFSETS,
+    SECTION_VERTEX_LABEL_POSTINGS,
+    SECTION_EDGE_LABEL_OFFSETS,
+    SECTION_EDGE_LABEL_POSTINGS,
+    SECTION_PROPERTY_COLUMNS, // SnapshotColumnEntry per column
+    SECTION_COUNT,            // Sections every snapshot has
+    SECTION_PROPERTY_VALUES = SECTION_COUNT,
+    SECTION_PROPERTY_PRESENT
+} SnapshotSection;
+
+typedef struct {
+    uint32_t kind;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t checksum;
+} SnapshotSectionEntry;
+
+typedef struct {
+    uint32_t key;         // String id
+    uint32_t type;        // PropertyType
+    uint32_t rows;        // vertex_count or edge_count
+    uint32_t reserved;
+} SnapshotColumnEntry;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t header_size;
+    uint32_t section_count;
+    uint32_t edge_record_size;
+    uint32_t flags;       // Bit 0: directed, bit 1: weighted
+    uint32_t vertex_count;
+    uint32_t edge_count;
+    uint32_t slot_count;
+    uint32_t string_count;
+    uint32_t string_slot_capacity;
+    uint32_t label_count;
+    uint32_t vertex_posting_count;
+    uint32_t edge_posting_count;
+    uint32_t vertex_column_count;
+    uint32_t edge_column_count;
+    uint64_t string_bytes;
+    uint64_t checksum;    // Header (with this field zero) + section table
+} SnapshotHeader;
+
+// Word-at-a-time multiplicative hash; the tail is folded in byte by byte
+static uint64_t snapshot_checksum(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = data;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+#define SNAPSHOT_SEED 0xcbf29ce484222325ULL
+
+static uint64_t snapshot_align(uint64_t offset) {
+    return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(uint64_t)(SNAPSHOT_ALIGNMENT - 1);
+}
+
+// Bytes of a presence bitmap covering rows
+static uint64_t snapshot_present_size(uint32_t rows) {
+    return ((uint64_t)rows + 63) / 64 * sizeof(uint64_t);
+}
+
+// Writes frozen to path. Returns false if the file could not be written.
+bool frozen_graph_save(const FrozenGraph* frozen, const char* path) {
+    uint32_t column_count = frozen->vertex_properties.column_count + frozen->edge_properties.column_count;
+    uint32_t section_count = SECTION_COUNT + 2 * column_count;
+    SnapshotColumnEntry* columns = calloc(column_count + 1, sizeof(SnapshotColumnEntry));
+    const void** data = malloc(section_count * sizeof(void*));
+    uint64_t* sizes = malloc(section_count * sizeof(uint64_t));
+    SnapshotSectionEntry* table = malloc(section_count * sizeof(SnapshotSectionEntry));
+
+    const void* fixed_data[SECTION_COUNT] = {
+        frozen->strings.data, frozen->strings.offsets, frozen->strings.slots,
+        frozen->offsets, frozen->targets, frozen->weights, frozen->slot_edge, frozen->edges,
+        frozen->label_ids, frozen->vertex_label_offsets, frozen->vertex_label_postings,
+        frozen->edge_label_offsets, frozen->edge_label_postings, columns
+    };
+    uint64_t fixed_sizes[SECTION_COUNT] = {
+        frozen->strings.size,
+        (uint64_t)frozen->strings.count * sizeof(uint32_t),
+        (uint64_t)frozen->strings.slot_capacity * sizeof(uint32_t),
+        ((uint64_t)frozen->vertex_count + 1) * sizeof(uint32_t),
+        (uint64_t)frozen->slot_count * sizeof(uint32_t),
+        (uint64_t)frozen->slot_count * sizeof(double),
+        (uint64_t)frozen->slot_count * sizeof(uint32_t),
+        (uint64_t)frozen->edge_count * sizeof(FrozenEdge),
+        (uint64_t)frozen->label_count * sizeof(uint32_t),
+        ((uint64_t)frozen->label_count + 1) * sizeof(uint32_t),
+        (uint64_t)frozen->vertex_label_offsets[frozen->label_count] * sizeof(uint32_t),
+        ((uint64_t)frozen->label_count + 1) * sizeof(uint32_t),
+        (uint64_t)frozen->edge_label_offsets[frozen->label_count] * sizeof(uint32_t),
+        (uint64_t)column_count * sizeof(SnapshotColumnEntry)
+    };
+    memcpy(data, fixed_data, sizeof(fixed_data));
+    memcpy(sizes, fixed_sizes, sizeof(fixed_sizes));
+    for (uint32_t c = 0; c < column_count; ++c) {
+        bool vertex_column = c < frozen->vertex_properties.column_count;
+        const PropertyColumn* column = vertex_column ? &frozen->vertex_properties.columns[c]
+                                                     : &frozen->edge_properties.columns[c - frozen->vertex_properties.column_count];
+        uint32_t rows = vertex_column ? frozen->vertex_count : frozen->edge_count;
+        string_table_find(&frozen->strings, column->key, &columns[c].key);
+        columns[c].type = column->type;
+        columns[c].rows = rows;
+        data[SECTION_COUNT + 2 * c] = column->values;
+        sizes[SECTION_COUNT + 2 * c] = (uint64_t)rows * property_type_size(column->type);
+        data[SECTION_COUNT + 2 * c + 1] = column->present;
+        sizes[SECTION_COUNT + 2 * c + 1] = snapshot_present_size(rows);
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, 8);
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.header_size = sizeof(SnapshotHeader);
+    header.section_count = section_count;
+    header.edge_record_size = sizeof(FrozenEdge);
+    header.flags = (frozen->is_directed ? 1u : 0u) | (frozen->is_weighted ? 2u : 0u);
+    header.vertex_count = frozen->vertex_count;
+    header.edge_count = frozen->edge_count;
+    header.slot_count = frozen->slot_count;
+    header.string_count = frozen->strings.count;
+    header.string_slot_capacity = frozen->strings.slot_capacity;
+    header.label_count = frozen->label_count;
+    header.vertex_posting_count = frozen->vertex_label_offsets[frozen->label_count];
+    header.edge_posting_count = frozen->edge_label_offsets[frozen->label_count];
+    header.vertex_column_count = frozen->vertex_properties.column_count;
+    header.edge_column_count = frozen->edge_properties.column_count;
+    header.string_bytes = frozen->strings.size;
+
+    size_t table_size = section_count * sizeof(SnapshotSectionEntry);
+    uint64_t offset = snapshot_align(sizeof(header) + table_size);
+    for (uint32_t kind = 0; kind < section_count; ++kind) {
+        table[kind].kind = kind < SECTION_COUNT ? kind : SECTION_PROPERTY_VALUES + (kind - SECTION_COUNT) % 2;
+        table[kind].reserved = 0;
+        table[kind].offset = offset;
+        table[kind].size = sizes[kind];
+        table[kind].checksum = sizes[kind] ? snapshot_checksum(SNAPSHOT_SEED, data[kind], sizes[kind]) : SNAPSHOT_SEED;
+        offset = snapshot_align(offset + sizes[kind]);
+    }
+    header.checksum = snapshot_checksum(snapshot_checksum(SNAPSHOT_SEED, &header, sizeof(header)), table, table_size);
+
+    FILE* file = fopen(path, "wb");
+    bool ok = file != NULL;
+    if (ok) {
+        static const char padding[SNAPSHOT_ALIGNMENT];
+        ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(table, table_size, 1, file) == 1;
+        uint64_t written = sizeof(header) + table_size;
+        for (uint32_t kind = 0; kind < section_count && ok; ++kind) {
+            ok = fwrite(padding, 1, table[kind].offset - written, file) == table[kind].offset - written &&
+                 (sizes[kind] == 0 || fwrite(data[kind], 1, sizes[kind], file) == sizes[kind]);
+            written = table[kind].offset + sizes[kind];
+        }
+        ok = fclose(file) == 0 && ok;
+    }
+    free(columns);
+    free(data);
+    free(sizes);
+    free(table);
+    return ok;
+}
+
+// Freezes graph and writes the snapshot to path
+bool graph_save(Graph* graph, const char* path) {
+    FrozenGraph* frozen = graph_freeze(graph);
+    if (!frozen) {
+        return false;
+    }
+    bool ok = frozen_graph_save(frozen, path);
+    frozen_graph_destroy(frozen);
+    return ok;
+}
+
+// Recomputes every section checksum of a mapped snapshot. graph_load_mmap()
+// only does this when asked, since it touches every page of the file.
+static bool snapshot_verify_sections(const char* base, const SnapshotSectionEntry* table, uint32_t section_count) {
+    for (uint32_t kind = 0; kind < section_count; ++kind) {
+        uint64_t checksum = table[kind].size ? snapshot_checksum(SNAPSHOT_SEED, base + table[kind].offset, table[kind].size)
+                                             : SNAPSHOT_SEED;
+        if (checksum != table[kind].checksum) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Checks that every fixed section is exactly as large as the header's counts
+// say, and that the string table can be probed, before any pointer into the
+// mapping is handed out
+static bool snapshot_check_sizes(const SnapshotHeader* header, const SnapshotSectionEntry* table) {
+    uint64_t column_count = (uint64_t)header->vertex_column_count + header->edge_column_count;
+    uint64_t expected[SECTION_COUNT] = {
+        header->string_bytes,
+        (uint64_t)header->string_count * sizeof(uint32_t),
+        (uint64_t)header->string_slot_capacity * sizeof(uint32_t),
+        ((uint64_t)header->vertex_count + 1) * sizeof(uint32_t),
+        (uint64_t)header->slot_count * sizeof(uint32_t),
+        (uint64_t)header->slot_count * sizeof(double),
+        (uint64_t)header->slot_count * sizeof(uint32_t),
+        (uint64_t)header->edge_count * sizeof(FrozenEdge),
+        (uint64_t)header->label_count * sizeof(uint32_t),
+        ((uint64_t)header->label_count + 1) * sizeof(uint32_t),
+        (uint64_t)header->vertex_posting_count * sizeof(uint32_t),
+        ((uint64_t)header->label_count + 1) * sizeof(uint32_t),
+        (uint64_t)header->edge_posting_count * sizeof(uint32_t),
+        column_count * sizeof(SnapshotColumnEntry)
+    };
+    for (int kind = 0; kind < SECTION_COUNT; ++kind) {
+        if (table[kind].size != expected[kind]) {
+            return false;
+        }
+    }
+    uint32_t slots = header->string_slot_capacity;
+    bool probeable = slots == 0 ? header->string_count == 0
+                                : (slots & (slots - 1)) == 0 && header->string_count < slots;
+    return probeable && header->vertex_count <= header->string_count;
+}
+
+// Checks the contents the loader cannot afford to trust even without
+// verify_payload: the row offsets and both label offset arrays must end at
+// the section sizes, and every string offset and hash slot must stay inside
+// the string table, whose text must end in a NUL. Costs O(labels + strings);
+// the adjacency arrays, edge records and postings are not read.
+static bool snapshot_check_bounds(const char* base, const SnapshotHeader* header, const SnapshotSectionEntry* table) {
+    const uint32_t* offsets = (const uint32_t*)(base + table[SECTION_OFFSETS].offset);
+    const uint32_t* vertex_label_offsets = (const uint32_t*)(base + table[SECTION_VERTEX_LABEL_OFFSETS].offset);
+    const uint32_t* edge_label_offsets = (const uint32_t*)(base + table[SECTION_EDGE_LABEL_OFFSETS].offset);
+    if (offsets[0] != 0 || offsets[header->vertex_count] != header->slot_count ||
+        vertex_label_offsets[0] != 0 || vertex_label_offsets[header->label_count] != header->vertex_posting_count ||
+        edge_label_offsets[0] != 0 || edge_label_offsets[header->label_count] != header->edge_posting_count) {
+        return false;
+    }
+    const char* data = base + table[SECTION_STRING_DATA].offset;
+    const uint32_t* string_offsets = (const uint32_t*)(base + table[SECTION_STRING_OFFSETS].offset);
+    const uint32_t* slots = (const uint32_t*)(base + table[SECTION_STRING_SLOTS].offset);
+    if (header->string_count > 0 && (header->string_bytes == 0 || data[header->string_bytes - 1] != '\0')) {
+        return false;
+    }
+    for (uint32_t id = 0; id < header->string_count; ++id) {
+        if (string_offsets[id] >= header->string_bytes) {
+            return false;
+        }
+    }
+    for (uint32_t slot = 0; slot < header->string_slot_capacity; ++slot) {
+        if (slots[slot] > header->string_count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Points a property table at the mapped columns described by entries
+static bool snapshot_map_columns(FrozenGraph* frozen, PropertyTable* table, const char* base,
+                                 const SnapshotColumnEntry* entries, const SnapshotSectionEntry* sections,
+                                 uint32_t column_count, uint32_t rows) {
+    table->strings = &frozen->strings;
+    table->columns = calloc(column_count + 1, sizeof(PropertyColumn));
+    table->column_count = column_count;
+    table->column_capacity = column_count;
+    for (uint32_t c = 0; c < column_count; ++c) {
+        const SnapshotColumnEntry* entry = &entries[c];
+        const SnapshotSectionEntry* values = &sections[2 * c];
+        const SnapshotSectionEntry* present = &sections[2 * c + 1];
+        if (entry->type > PROPERTY_STRING || entry->key >= frozen->strings.count || entry->rows != rows ||
+            values->size != (uint64_t)rows * property_type_size(entry->type) ||
+            present->size != snapshot_present_size(rows)) {
+            return false;
+        }
+        PropertyColumn* column = &table->columns[c];
+        // The mapping is read-only; keys and values are never written through
+        column->key = (char*)string_table_get(&frozen->strings, entry->key);
+        column->type = entry->type;
+        column->values = (void*)(base + values->offset);
+        column->present = (uint64_t*)(base + present->offset);
+        column->capacity = rows;
+    }
+    return true;
+}
+
+// Maps a snapshot written by graph_save() read-only and returns a FrozenGraph
+// whose arrays and property columns point into the mapping; nothing is
+// parsed or copied. The header, section table, string table and the ends of
+// the offset arrays are always validated; verify_payload also checks the
+// section checksums. Without it the interior of the file is trusted:
+// row offsets rising, targets, edge records, label ids, postings and string
+// property values in range. A corrupt file that keeps its sizes can then
+// cause out-of-bounds reads, so pass verify_payload for files that may be
+// damaged. Returns NULL if the file is missing, truncated, from another
+// version or build, or corrupt. Release it with frozen_graph_destroy().
+FrozenGraph* graph_load_mmap(const char* path, bool verify_payload) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (uint64_t)info.st_size < sizeof(SnapshotHeader) + sizeof(SnapshotSectionEntry) * SECTION_COUNT) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)info.st_size;
+    char* base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    SnapshotHeader header;
+    memcpy(&header, base, sizeof(header));
+    const SnapshotSectionEntry* table = (const SnapshotSectionEntry*)(base + sizeof(header));
+    uint64_t column_count = (uint64_t)header.vertex_column_count + header.edge_column_count;
+    uint64_t stored = header.checksum;
+    header.checksum = 0;
+    bool valid = memcmp(header.magic, SNAPSHOT_MAGIC, 8) == 0 && header.version == SNAPSHOT_VERSION &&
+                 header.byte_order == SNAPSHOT_BYTE_ORDER && header.header_size == sizeof(SnapshotHeader) &&
+                 header.section_count == SECTION_COUNT + 2 * column_count &&
+                 header.section_count <= (size - sizeof(header)) / sizeof(SnapshotSectionEntry) &&
+                 header.edge_record_size == sizeof(FrozenEdge) &&
+                 snapshot_checksum(snapshot_checksum(SNAPSHOT_SEED, &header, sizeof(header)), table,
+                                   sizeof(SnapshotSectionEntry) * header.section_count) == stored;
+    for (uint32_t kind = 0; kind < header.section_count && valid; ++kind) {
+        uint32_t expected = kind < SECTION_COUNT ? kind : SECTION_PROPERTY_VALUES + (kind - SECTION_COUNT) % 2;
+        valid = table[kind].kind == expected && table[kind].offset % SNAPSHOT_ALIGNMENT == 0 &&
+                table[kind].offset <= size && table[kind].size <= size - table[kind].offset;
+    }
+    valid = valid && snapshot_check_sizes(&header, table) && snapshot_check_bounds(base, &header, table);
+    if (valid && verify_payload) {
+        valid = snapshot_verify_sections(base, table, header.section_count);
+    }
+    if (!valid) {
+        munmap(base, size);
+        return NULL;
+    }
+
+    FrozenGraph* frozen = calloc(1, sizeof(FrozenGraph));
+    frozen->mapping = base;
+    frozen->mapping_size = size;
+    frozen->is_directed = (header.flags & 1u) != 0;
+    frozen->is_weighted = (header.flags & 2u) != 0;
+    frozen->vertex_count = header.vertex_count;
+    frozen->edge_count = header.edge_count;
+    frozen->slot_count = header.slot_count;
+    frozen->strings.data = base + table[SECTION_STRING_DATA].offset;
+    frozen->strings.size = header.string_bytes;
+    frozen->strings.offsets = (uint32_t*)(base + table[SECTION_STRING_OFFSETS].offset);
+    frozen->strings.count = header.string_count;
+    frozen->strings.slots = (uint32_t*)(base + table[SECTION_STRING_SLOTS].offset);
+    frozen->strings.slot_capacity = header.string_slot_capacity;
+    frozen->offsets = (uint32_t*)(base + table[SECTION_OFFSETS].offset);
+    frozen->targets = (uint32_t*)(base + table[SECTION_TARGETS].offset);
+    frozen->weights = (double*)(base + table[SECTION_WEIGHTS].offset);
+    frozen->slot_edge = (uint32_t*)(base + table[SECTION_SLOT_EDGE].offset);
+    frozen->edges = (FrozenEdge*)(base + table[SECTION_EDGES].offset);
+    frozen->label_count = header.label_count;
+    frozen->label_ids = (uint32_t*)(base + table[SECTION_LABEL_IDS].offset);
+    frozen->vertex_label_offsets = (uint32_t*)(base + table[SECTION_VERTEX_LABEL_OFFSETS].offset);
+    frozen->vertex_label_postings = (uint32_t*)(base + table[SECTION_VERTEX_LABEL_POSTINGS].offset);
+    frozen->edge_label_offsets = (uint32_t*)(base + table[SECTION_EDGE_LABEL_OFFSETS].offset);
+    frozen->edge_label_postings = (uint32_t*)(base + table[SECTION_EDGE_LABEL_POSTINGS].offset);
+    const SnapshotColumnEntry* columns = (const SnapshotColumnEntry*)(base + table[SECTION_PROPERTY_COLUMNS].offset);
+    const SnapshotSectionEntry* column_sections = table + SECTION_COUNT;
+    if (!snapshot_map_columns(frozen, &frozen->vertex_properties, base, columns, column_sections,
+                              header.vertex_column_count, frozen->vertex_count) ||
+        !snapshot_map_columns(frozen, &frozen->edge_properties, base, columns + header.vertex_column_count,
+                              column_sections + 2 * header.vertex_column_count, header.edge_column_count,
+                              frozen->edge_count)) {
+        frozen_graph_destroy(frozen);
+        return NULL;
+    }
+    return frozen;
+}
+
+// --- Bulk Import ---
+
+// Builds a FrozenGraph straight from a large text file: an edge list
+// ("source target [weight [label]]", whitespace separated), CSV with the
+// same columns, or a Pen script (Create Node / Connect lines). The mapped
+// file is split at line boundaries into one chunk per thread. Each thread
+// parses its chunk and interns ids in its own string tables. The local
+// tables are merged into the frozen table, and the threads then remap
+// their edges and fill the CSR rows in parallel. Rows are sorted by edge
+// record afterwards, so the result does not depend on thread timing.
+// Blank lines and lines starting with '#' or '%' are skipped; lines that
+// do not parse are counted in skipped_lines.
+
+#define IMPORT_MAX_THREADS 64
+#define IMPORT_PROGRESS_BYTES (1 << 20)  // Parsed bytes are published in steps of this
+
+typedef enum {
+    IMPORT_EDGE_LIST,
+    IMPORT_CSV,
+    IMPORT_PEN
+} ImportFormat;
+
+typedef struct {
+    ImportFormat format;
+    bool directed;
+    bool has_header;      // CSV: skip the first line
+    int threads;          // 0 = one per online processor
+} ImportOptions;
+
+typedef enum {
+    IMPORT_PHASE_PARSING,
+    IMPORT_PHASE_MERGING,
+    IMPORT_PHASE_BUILDING,
+    IMPORT_PHASE_DONE
+} ImportPhase;
+
+// Live counters, safe to read from another thread while graph_import() runs.
+// graph_import() resets every field with atomic stores, so a monitor may
+// already be polling when the import starts.
+typedef struct {
+    _Atomic int phase;
+    _Atomic uint64_t bytes_total;
+    _Atomic uint64_t bytes_parsed;
+    _Atomic uint64_t lines;
+    _Atomic uint64_t skipped_lines;
+    _Atomic uint64_t edges;
+    _Atomic uint64_t vertices;    // Known once merging is done
+    _Atomic uint64_t started_ns;  // CLOCK_MONOTONIC; zero until the import starts
+} ImportProgress;
+
+typedef struct {
+    StringTable vertex_ids;
+    StringTable labels;
+    uint32_t* sources;    // Local vertex ids until remapped
+    uint32_t* targets;
+    uint32_t* edge_labels;
+    double* weights;
+    size_t edge_count;
+    size_t edge_capacity;
+    bool weighted;
+    uint32_t* vertex_map; // Local -> frozen ids
+    uint32_t* label_map;
+    uint32_t first_edge;  // Frozen record of this chunk's first edge
+} ImportChunk;
+
+typedef struct {
+    const char* data;
+    size_t size;
+    const ImportOptions* options;
+    ImportProgress* progress;
+    ImportChunk chunks[IMPORT_MAX_THREADS];
+    size_t chunk_begin[IMPORT_MAX_THREADS + 1];
+    int thread_count;
+    FrozenGraph* frozen;
+    uint32_t* cursors;    // Next free slot per row while filling
+} ImportJob;
+
+typedef struct {
+    ImportJob* job;
+    int index;
+    void (*run)(ImportJob* job, int index);
+} ImportWorker;
+
+static uint64_t import_clock_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static void import_progress_reset(ImportProgress* progress) {
+    atomic_store(&progress->started_ns, 0);
+    atomic_store(&progress->phase, IMPORT_PHASE_PARSING);
+    atomic_store(&progress->bytes_total, 0);
+    atomic_store(&progress->bytes_parsed, 0);
+    atomic_store(&progress->lines, 0);
+    atomic_store(&progress->skipped_lines, 0);
+    atomic_store(&progress->edges, 0);
+    atomic_store(&progress->vertices, 0);
+    atomic_store(&progress->started_ns, import_clock_ns());
+}
+
+// Milliseconds since the import started, or 0 before it has
+double graph_import_elapsed_ms(const ImportProgress* progress) {
+    uint64_t started = atomic_load(&progress->started_ns);
+    return started ? (import_clock_ns() - started) / 1e6 : 0;
+}
+
+// Parsed bytes per second so far
+double graph_import_throughput(const ImportProgress* progress) {
+    double elapsed = graph_import_elapsed_ms(progress);
+    return elapsed > 0 ? atomic_load(&progress->bytes_parsed) * 1000.0 / elapsed : 0;
+}
+
+// Splits [*cursor, end) at the next field: whitespace for edge lists and Pen,
+// commas for CSV (surrounding quotes and spaces are dropped). Returns false
+// when the line has no more fields.
+static bool import_next_field(const char** cursor, const char* end, ImportFormat format, const char** field, size_t* length) {
+    const char* p = *cursor;
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        ++p;
+    }
+    if (p >= end) {
+        return false;
+    }
+    const char* start = p;
+    if (format == IMPORT_CSV) {
+        while (p < end && *p != ',') {
+            ++p;
+        }
+        *cursor = p < end ? p + 1 : p;
+        while (p > start && (p[-1] == ' ' || p[-1] == '\t' || p[-1] == '\r')) {
+            --p;
+        }
+        if (p - start >= 2 && *start == '"' && p[-1] == '"') {
+            ++start;
+            --p;
+        }
+    } else {
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r') {
+            ++p;
+        }
+        *cursor = p;
+    }
+    *field = start;
+    *length = (size_t)(p - start);
+    return true;
+}
+
+// Interns a field that is not NUL-terminated, copying it through scratch
+static uint32_t import_intern(StringTable* table, const char* field, size_t length, char** scratch, size_t* scratch_capacity) {
+    if (length + 1 > *scratch_capacity) {
+        *scratch_capacity = 2 * (length + 1);
+        *scratch = realloc(*scratch, *scratch_capacity);
+    }
+    memcpy(*scratch, field, length);
+    (*scratch)[length] = '\0';
+    return string_table_intern(table, *scratch);
+}
+
+static bool import_parse_weight(const char* field, size_t length, double* weight) {
+    char buffer[64];
+    if (length == 0 || length >= sizeof(buffer)) {
+        return false;
+    }
+    memcpy(buffer, field, length);
+    buffer[length] = '\0';
+    char* end;
+    *weight = strtod(buffer, &end);
+    return end == buffer + length;
+}
+
+static bool import_field_is(const char* field, size_t length, const char* word) {
+    return strlen(word) == length && memcmp(field, word, length) == 0;
+}
+
+static bool import_field_is_nocase(const char* field, size_t length, const char* word) {
+    return strlen(word) == length && strncasecmp(field, word, length) == 0;
+}
+
+static void import_push_edge(ImportChunk* chunk, uint32_t source, uint32_t target, double weight, uint32_t label) {
+    if (chunk->edge_count == chunk->edge_capacity) {
+        chunk->edge_capacity = chunk->edge_capacity ? chunk->edge_capacity * 2 : 4096;
+        chunk->sources = realloc(chunk->sources, chunk->edge_capacity * sizeof(uint32_t));
+        chunk->targets = realloc(chunk->targets, chunk->edge_capacity * sizeof(uint32_t));
+        chunk->edge_labels = realloc(chunk->edge_labels, chunk->edge_capacity * sizeof(uint32_t));
+        chunk->weights = realloc(chunk->weights, chunk->edge_capacity * sizeof(double));
+    }
+    chunk->sources[chunk->edge_count] = source;
+    chunk->targets[chunk->edge_count] = target;
+    chunk->weights[chunk->edge_count] = weight;
+    chunk->edge_labels[chunk->edge_count] = label;
+    chunk->edge_count++;
+}
+
+#define PEN_MAX_FIELDS 8  // Connect a to b WEIGHT w with, and room to spare
+
+// Parses one line into the chunk; returns false if it is malformed
+static bool import_parse_line(ImportChunk* chunk, const char* line, const char* end, ImportFormat format,
+                              char** scratch, size_t* scratch_capacity) {
+    const char* fields[PEN_MAX_FIELDS];
+    size_t lengths[PEN_MAX_FIELDS];
+    int count = 0;
+    const char* cursor = line;
+    if (format == IMPORT_PEN) {
+        // Create Node <id> [...]. / Connect <a> to <b> [WEIGHT <w>] [with {...}].
+        const char* brace = memchr(line, '{', (size_t)(end - line));
+        const char* stop = brace ? brace : end;
+        while (count < PEN_MAX_FIELDS && import_next_field(&cursor, stop, format, &fields[count], &lengths[count])) {
+            ++count;
+        }
+        // The period belongs to whichever field ends the statement; a lone
+        // period is no field at all
+        const char* rest;
+        size_t rest_length;
+        bool ends_statement = count > 0 && !brace && !import_next_field(&cursor, stop, format, &rest, &rest_length);
+        if (ends_statement && fields[count - 1][lengths[count - 1] - 1] == '.') {
+            lengths[count - 1]--;
+            if (lengths[count - 1] == 0) {
+                --count;
+            }
+        }
+        if (count >= 3 && import_field_is(fields[0], lengths[0], "Create") && import_field_is(fields[1], lengths[1], "Node")) {
+            import_intern(&chunk->vertex_ids, fields[2], lengths[2], scratch, scratch_capacity);
+            return true;
+        }
+        if (count >= 4 && import_field_is(fields[0], lengths[0], "Connect") && import_field_is_nocase(fields[2], lengths[2], "to")) {
+            double weight = 1.0;
+            int next = 4;
+            if (next < count && import_field_is_nocase(fields[next], lengths[next], "WEIGHT")) {
+                if (next + 1 >= count || !import_parse_weight(fields[next + 1], lengths[next + 1], &weight)) {
+                    return false;
+                }
+                chunk->weighted = true;
+                next += 2;
+            }
+            if (next < count && !(next == count - 1 && import_field_is_nocase(fields[next], lengths[next], "with"))) {
+                return false;
+            }
+            uint32_t source = import_intern(&chunk->vertex_ids, fields[1], lengths[1], scratch, scratch_capacity);
+            uint32_t target = import_intern(&chunk->vertex_ids, fields[3], lengths[3], scratch, scratch_capacity);
+            import_push_edge(chunk, source, target, weight, FROZEN_NO_LABEL);
+            return true;
+        }
+        // Other Pen statements (Set, Eval, Reset, ...) carry no structure
+        return count > 0 && !import_field_is(fields[0], lengths[0], "Connect") &&
+               !import_field_is(fields[0], lengths[0], "Create");
+    }
+
+    while (count < 4 && import_next_field(&cursor, end, format, &fields[count], &lengths[count])) {
+        ++count;
+    }
+    if (count < 2 || lengths[0] == 0 || lengths[1] == 0) {
+        return false;
+    }
+    double weight = 1.0;
+    if (count >= 3 && lengths[2] > 0) {
+        if (!import_parse_weight(fields[2], lengths[2], &weight)) {
+            return false;
+        }
+        chunk->weighted = true;
+    }
+    uint32_t label = FROZEN_NO_LABEL;
+    if (count == 4 && lengths[3] > 0) {
+        label = import_intern(&chunk->labels, fields[3], lengths[3], scratch, scratch_capacity);
+    }
+    uint32_t source = import_intern(&chunk->vertex_ids, fields[0], lengths[0], scratch, scratch_capacity);
+    uint32_t target = import_intern(&chunk->vertex_ids, fields[1], lengths[1], scratch, scratch_capacity);
+    import_push_edge(chunk, source, target, weight, label);
+    return true;
+}
+
+static void import_parse_chunk(ImportJob* job, int index) {
+    ImportChunk* chunk = &job->chunks[index];
+    ImportProgress* progress = job->progress;
+    const char* p = job->data + job->chunk_begin[index];
+    const char* end = job->data + job->chunk_begin[index + 1];
+    const char* published = p;
+    char* scratch = NULL;
+    size_t scratch_capacity = 0;
+    uint64_t lines = 0, skipped = 0;
+    bool skip_header = index == 0 && job->options->format == IMPORT_CSV && job->options->has_header;
+
+    while (p < end) {
+        const char* newline = memchr(p, '\n', (size_t)(end - p));
+        const char* line_end = newline ? newline : end;
+        const char* first = p;
+        while (first < line_end && (*first == ' ' || *first == '\t' || *first == '\r')) {
+            ++first;
+        }
+        if (skip_header) {
+            skip_header = false;
+        } else if (first < line_end && *first != '#' && *first != '%') {
+            ++lines;
+            if (!import_parse_line(chunk, first, line_end, job->options->format, &scratch, &scratch_capacity)) {
+                ++skipped;
+            }
+        }
+        p = newline ? newline + 1 : end;
+        if (p - published >= IMPORT_PROGRESS_BYTES) {
+            atomic_fetch_add(&progress->bytes_parsed, (uint64_t)(p - published));
+            atomic_fetch_add(&progress->lines, lines);
+            atomic_fetch_add(&progress->skipped_lines, skipped);
+            published = p;
+            lines = skipped = 0;
+        }
+    }
+    atomic_fetch_add(&progress->bytes_parsed, (uint64_t)(p - published));
+    atomic_fetch_add(&progress->lines, lines);
+    atomic_fetch_add(&progress->skipped_lines, skipped);
+    atomic_fetch_add(&progress->edges, chunk->edge_count);
+    free(scratch);
+}
+
+// Rewrites a chunk's edges as frozen records and counts row lengths
+static void import_remap_chunk(ImportJob* job, int index) {
+    ImportChunk* chunk = &job->chunks[index];
+    FrozenGraph* frozen = job->frozen;
+    for (size_t i = 0; i < chunk->edge_count; ++i) {
+        FrozenEdge* edge = &frozen->edges[chunk->first_edge + i];
+        edge->source = chunk->vertex_map[chunk->sources[i]];
+        edge->target = chunk->vertex_map[chunk->targets[i]];
+        edge->weight = chunk->weights[i];
+        edge->label = chunk->edge_labels[i] == FROZEN_NO_LABEL ? FROZEN_NO_LABEL : chunk->label_map[chunk->edge_labels[i]];
+        edge->directed = job->options->directed;
+        // offsets[v + 1] collects row lengths; the prefix sum comes later
+        __atomic_fetch_add(&frozen->offsets[edge->source + 1], 1, __ATOMIC_RELAXED);
+        if (!edge->directed && edge->target != edge->source) {
+            __atomic_fetch_add(&frozen->offsets[edge->target + 1], 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void import_fill_chunk(ImportJob* job, int index) {
+    ImportChunk* chunk = &job->chunks[index];
+    FrozenGraph* frozen = job->frozen;
+    for (uint32_t record = chunk->first_edge; record < chunk->first_edge + chunk->edge_count; ++record) {
+        const FrozenEdge* edge = &frozen->edges[record];
+        frozen->slot_edge[__atomic_fetch_add(&job->cursors[edge->source], 1, __ATOMIC_RELAXED)] = record;
+        if (!edge->directed && edge->target != edge->source) {
+            frozen->slot_edge[__atomic_fetch_add(&job->cursors[edge->target], 1, __ATOMIC_RELAXED)] = record;
+        }
+    }
+}
+
+// Sorts this thread's share of rows by edge record and fills targets/weights
+static void import_finish_rows(ImportJob* job, int index) {
+    FrozenGraph* frozen = job->frozen;
+    uint32_t first = (uint32_t)((uint64_t)frozen->vertex_count * index / job->thread_count);
+    uint32_t last = (uint32_t)((uint64_t)frozen->vertex_count * (index + 1) / job->thread_count);
+    for (uint32_t v = first; v < last; ++v) {
+        uint32_t begin = frozen->offsets[v], end = frozen->offsets[v + 1];
+        if (end - begin > 1) {
+            qsort(frozen->slot_edge + begin, end - begin, sizeof(uint32_t), frozen_compare_ids);
+        }
+        for (uint32_t slot = begin; slot < end; ++slot) {
+            const FrozenEdge* edge = &frozen->edges[frozen->slot_edge[slot]];
+            frozen->targets[slot] = edge->source == v ? edge->target : edge->source;
+            frozen->weights[slot] = edge->weight;
+        }
+    }
+}
+
+static void* import_worker_main(void* argument) {
+    ImportWorker* worker = argument;
+    worker->run(worker->job, worker->index);
+    return NULL;
+}
+
+// Runs one phase on every thread; a thread that cannot start runs inline
+static void import_run_phase(ImportJob* job, void (*run)(ImportJob* job, int index)) {
+    ImportWorker workers[IMPORT_MAX_THREADS];
+    pthread_t threads[IMPORT_MAX_THREADS];
+    bool started[IMPORT_MAX_THREADS];
+    for (int i = 0; i < job->thread_count; ++i) {
+        workers[i].job = job;
+        workers[i].index = i;
+        workers[i].run = run;
+        started[i] = i > 0 && pthread_create(&threads[i], NULL, import_worker_main, &workers[i]) == 0;
+    }
+    for (int i = 0; i < job->thread_count; ++i) {
+        if (!started[i]) {
+            run(job, i);
+        }
+    }
+    for (int i = 1; i < job->thread_count; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+    }
+}
+
+static void import_free_chunk(ImportChunk* chunk) {
+    string_table_free(&chunk->vertex_ids);
+    string_table_free(&chunk->labels);
+    free(chunk->sources);
+    free(chunk->targets);
+    free(chunk->edge_labels);
+    free(chunk->weights);
+    free(chunk->vertex_map);
+    free(chunk->label_map);
+}
+
+// Imports path into a new FrozenGraph (release with frozen_graph_destroy()).
+// progress may be NULL; otherwise it is reset and kept up to date. Returns
+// NULL if the file cannot be read or the graph outgrows 32-bit ids.
+FrozenGraph* graph_import(const char* path, const ImportOptions* options, ImportProgress* progress) {
+    ImportProgress local_progress;
+    if (!progress) {
+        progress = &local_progress;
+    }
+    import_progress_reset(progress);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)info.st_size;
+    const char* data = size ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    atomic_store(&progress->bytes_total, (uint64_t)size);
+
+    ImportJob* job = calloc(1, sizeof(ImportJob));
+    job->data = data;
+    job->size = size;
+    job->options = options;
+    job->progress = progress;
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    job->thread_count = options->threads > 0 ? options->threads : (processors > 0 ? (int)processors : 1);
+    if (job->thread_count > IMPORT_MAX_THREADS) {
+        job->thread_count = IMPORT_MAX_THREADS;
+    }
+    // Chunks start right after a newline. An empty file has no mapping and
+    // leaves every chunk empty.
+    if (size > 0) {
+        for (int i = 0; i <= job->thread_count; ++i) {
+            size_t begin = (size_t)((uint64_t)size * i / job->thread_count);
+            if (i > 0 && i < job->thread_count) {
+                const char* newline = memchr(data + begin, '\n', size - begin);
+                begin = newline ? (size_t)(newline - data) + 1 : size;
+            }
+            if (i > 0 && begin < job->chunk_begin[i - 1]) {
+                begin = job->chunk_begin[i - 1];
+            }
+            job->chunk_begin[i] = begin;
+        }
+        import_run_phase(job, import_parse_chunk);
+    }
+
+    // Merge local ids: vertex ids first (frozen vertex v is string v), then
+    // labels, in chunk order so the numbering is reproducible
+    atomic_store(&progress->phase, IMPORT_PHASE_MERGING);
+    FrozenGraph* frozen = calloc(1, sizeof(FrozenGraph));
+    job->frozen = frozen;
+    frozen->is_directed = options->directed;
+    uint64_t edge_count = 0;
+    for (int i = 0; i < job->thread_count; ++i) {
+        ImportChunk* chunk = &job->chunks[i];
+        chunk->vertex_map = malloc((chunk->vertex_ids.count + 1) * sizeof(uint32_t));
+        for (uint32_t id = 0; id < chunk->vertex_ids.count; ++id) {
+            chunk->vertex_map[id] = string_table_intern(&frozen->strings, string_table_get(&chunk->vertex_ids, id));
+        }
+        chunk->first_edge = (uint32_t)edge_count;
+        edge_count += chunk->edge_count;
+        frozen->is_weighted |= chunk->weighted;
+    }
+    frozen->vertex_count = frozen->strings.count;
+    for (int i = 0; i < job->thread_count; ++i) {
+        ImportChunk* chunk = &job->chunks[i];
+        chunk->label_map = malloc((chunk->labels.count + 1) * sizeof(uint32_t));
+        for (uint32_t id = 0; id < chunk->labels.count; ++id) {
+            chunk->label_map[id] = string_table_intern(&frozen->strings, string_table_get(&chunk->labels, id));
+        }
+    }
+    atomic_store(&progress->vertices, frozen->vertex_count);
+    bool strings_fit = !frozen->strings.full;
+    for (int i = 0; i < job->thread_count; ++i) {
+        strings_fit = strings_fit && !job->chunks[i].vertex_ids.full && !job->chunks[i].labels.full;
+    }
+
+    FrozenGraph* result = NULL;
+    if (strings_fit && edge_count < UINT32_MAX) {
+        atomic_store(&progress->phase, IMPORT_PHASE_BUILDING);
+        frozen->edge_count = (uint32_t)edge_count;
+        frozen->edges = calloc(edge_count + 1, sizeof(FrozenEdge));
+        frozen->offsets = calloc(frozen->vertex_count + 1, sizeof(uint32_t));
+        import_run_phase(job, import_remap_chunk);
+        uint64_t slots = 0;
+        for (uint32_t v = 0; v < frozen->vertex_count; ++v) {
+            slots += frozen->offsets[v + 1];
+            frozen->offsets[v + 1] = (uint32_t)slots;
+        }
+        if (slots < UINT32_MAX) {
+            frozen->slot_count = (uint32_t)slots;
+            frozen->targets = malloc((slots + 1) * sizeof(uint32_t));
+            frozen->weights = malloc((slots + 1) * sizeof(double));
+            frozen->slot_edge = malloc((slots + 1) * sizeof(uint32_t));
+            job->cursors = malloc((frozen->vertex_count + 1) * sizeof(uint32_t));
+            memcpy(job->cursors, frozen->offsets, (frozen->vertex_count + 1) * sizeof(uint32_t));
+            import_run_phase(job, import_fill_chunk);
+            import_run_phase(job, import_finish_rows);
+            frozen_index_labels(frozen, NULL, NULL);
+            frozen->vertex_properties.strings = &frozen->strings;
+            frozen->edge_properties.strings = &frozen->strings;
+            result = frozen;
+        }
+    }
+    if (!result) {
+        frozen_graph_destroy(frozen);
+    }
+
+    for (int i = 0; i < job->thread_count; ++i) {
+        import_free_chunk(&job->chunks[i]);
+    }
+    free(job->cursors);
+    free(job);
+    if (size) {
+        munmap((void*)data, size);
+    }
+    atomic_store(&progress->phase, IMPORT_PHASE_DONE);
+    return result;
+}
+
+// --- Concurrent Versions ---
+
+// Lets analytics run while one thread ingests. The writer owns a mutable
+// Graph and, whenever it wants readers to see its changes, publishes an
+// immutable FrozenGraph built from it. Readers never lock: they announce
+// the epoch they entered in, load the current version and read it freely.
+// A replaced version is retired with the epoch in force after the swap and
+// freed once every reader that could still hold it has left.
+//
+// A publish freezes the whole graph, so it costs O(V + E); writers batch
+// inserts between publishes.
+
+#define VERSION_MAX_READERS 64
+#define VERSION_READER_IDLE UINT64_MAX
+
+typedef struct {
+    FrozenGraph* frozen;
+    uint64_t number;          // 1 for the first publish, then increasing
+    uint64_t retired_epoch;   // Set when the version is replaced
+} GraphVersion;
+
+typedef struct {
+    _Atomic uint64_t epoch;   // Epoch entered in, or VERSION_READER_IDLE
+    _Atomic bool claimed;     // Owned by a registered reader
+    char padding[55];         // One reader per cache line
+} VersionReaderSlot;
+
+typedef struct {
+    Graph* graph;             // Writer only
+    _Atomic(GraphVersion*) current;
+    _Atomic uint64_t epoch;
+    VersionReaderSlot readers[VERSION_MAX_READERS];
+    GraphVersion** retired;   // Writer only: versions waiting to be freed
+    size_t retired_count;
+    size_t retired_capacity;
+    uint64_t next_number;
+} VersionedGraph;
+
+// Creates an empty versioned graph whose first version is empty
+VersionedGraph* versioned_graph_create() {
+    VersionedGraph* versioned = calloc(1, sizeof(VersionedGraph));
+    versioned->graph = graph_create();
+    for (int i = 0; i < VERSION_MAX_READERS; ++i) {
+        atomic_init(&versioned->readers[i].epoch, VERSION_READER_IDLE);
+        atomic_init(&versioned->readers[i].claimed, false);
+    }
+    atomic_init(&versioned->epoch, 1);
+    GraphVersion* version = calloc(1, sizeof(GraphVersion));
+    version->frozen = graph_freeze(versioned->graph);
+    version->number = ++versioned->next_number;
+    atomic_init(&versioned->current, version);
+    return versioned;
+}
+
+// Claims a free reader slot for the calling thread. Returns -1 when all
+// VERSION_MAX_READERS slots are taken.
+int versioned_graph_register_reader(VersionedGraph* versioned) {
+    for (int reader = 0; reader < VERSION_MAX_READERS; ++reader) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&versioned->readers[reader].claimed, &expected, true)) {
+            return reader;
+        }
+    }
+    return -1;
+}
+
+// Gives a slot back for another thread to register. The reader must be
+// outside any read section.
+void versioned_graph_unregister_reader(VersionedGraph* versioned, int reader) {
+    atomic_store(&versioned->readers[reader].epoch, VERSION_READER_IDLE);
+    atomic_store_explicit(&versioned->readers[reader].claimed, false, memory_order_release);
+}
+
+// Pins and returns the current version. It stays valid, and unchanged,
+// until the matching versioned_graph_read_end.
+const GraphVersion* versioned_graph_read_begin(VersionedGraph* versioned, int reader) {
+    // The epoch is announced before the version is loaded: a writer that
+    // sees this slot idle has already swapped, so the load gets the new one
+    atomic_store(&versioned->readers[reader].epoch, atomic_load(&versioned->epoch));
+    return atomic_load(&versioned->current);
+}
+
+void versioned_graph_read_end(VersionedGraph* versioned, int reader) {
+    atomic_store_explicit(&versioned->readers[reader].epoch, VERSION_READER_IDLE, memory_order_release);
+}
+
+// Frees retired versions no reader can still hold. Returns how many are
+// still waiting. Writer only.
+size_t versioned_graph_reclaim(VersionedGraph* versioned) {
+    // Unclaimed slots are idle, so every slot can be scanned
+    uint64_t oldest = VERSION_READER_IDLE;
+    for (int i = 0; i < VERSION_MAX_READERS; ++i) {
+        uint64_t epoch = atomic_load(&versioned->readers[i].epoch);
+        if (epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    // A reader that entered at epoch e may hold any version retired after e
+    size_t kept = 0;
+    for (size_t i = 0; i < versioned->retired_count; ++i) {
+        GraphVersion* version = versioned->retired[i];
+        if (version->retired_epoch <= oldest) {
+            frozen_graph_destroy(version->frozen);
+            free(version);
+        } else {
+            versioned->retired[kept++] = version;
+        }
+    }
+    versioned->retired_count = kept;
+    return kept;
+}
+
+// Freezes the writer's graph and makes it the current version, then
+// reclaims what it can. Returns the new version number, or 0 if the graph
+// cannot be frozen (the current version stays). Writer only.
+uint64_t versioned_graph_publish(VersionedGraph* versioned) {
+    FrozenGraph* frozen = graph_freeze(versioned->graph);
+    if (!frozen) {
+        return 0;
+    }
+    GraphVersion* version = calloc(1, sizeof(GraphVersion));
+    version->frozen = frozen;
+    version->number = ++versioned->next_number;
+
+    GraphVersion* previous = atomic_exchange(&versioned->current, version);
+    previous->retired_epoch = atomic_fetch_add(&versioned->epoch, 1) + 1;
+    if (versioned->retired_count == versioned->retired_capacity) {
+        versioned->retired_capacity = versioned->retired_capacity ? versioned->retired_capacity * 2 : 8;
+        versioned->retired = realloc(versioned->retired, versioned->retired_capacity * sizeof(GraphVersion*));
+    }
+    versioned->retired[versioned->retired_count++] = previous;
+    versioned_graph_reclaim(versioned);
+    return version->number;
+}
+
+// Frees everything. No reader may be inside a read section.
+void versioned_graph_destroy(VersionedGraph* versioned) {
+    for (size_t i = 0; i < versioned->retired_count; ++i) {
+        frozen_graph_destroy(versioned->retired[i]->frozen);
+        free(versioned->retired[i]);
+    }
+    free(versioned->retired);
+    GraphVersion* current = atomic_load(&versioned->current);
+    frozen_graph_destroy(current->frozen);
+    free(current);
+    graph_destroy(versioned->graph);
+    free(versioned);
+}
@@ -0,0 +1,247 @@
+// Stress check for the concurrent versions in grapha.c. Reader threads
+// repeatedly pin versions and verify them while the writer inserts edges
+// and publishes every publish_every edges. Each version must be internally
+// consistent (row lengths add up, targets in range, edge count matching its
+// number) and a reader must never see versions go backwards. Readers give
+// their slot back and register again every so often, so slots are reused.
+//
+// grapha.c expects an external hash map; this file supplies a small one and
+// compiles the library into the same translation unit:
+//
+//   cc -O2 -pthread grapha_stress.c -luuid -o grapha_stress
+//   ./grapha_stress [readers [edges [publish_every]]]
+//
+// Build with -fsanitize=address or -fsanitize=thread to also catch early
+// frees and races. Exits non-zero if any reader found a problem.
+
+#include <stdlib.h>
+#include <string.h>
+
+// --- Stub Hash Map ---
+
+// Chained buckets for lookups plus a list in insertion order for iteration.
+// Keys are borrowed: grapha.c keeps them alive until hashmap_destroy.
+
+typedef struct hashmap_entry {
+    const char* key;
+    void* value;
+    struct hashmap_entry* bucket_next;
+    struct hashmap_entry* next;
+} hashmap_entry;
+
+struct hashmap {
+    hashmap_entry** buckets;
+    size_t bucket_count;   // Zero or a power of two
+    size_t count;
+    hashmap_entry* head;
+    hashmap_entry* tail;
+};
+
+#define hashmap_foreach_key_start(map, key) \
+    for (hashmap_entry* entry_ = (map)->head; entry_ && ((key) = entry_->key, true); entry_ = entry_->next)
+#define hashmap_foreach_key_end()
+
+#include "grapha.c"
+
+static size_t hashmap_bucket(const struct hashmap* map, const char* key) {
+    return string_hash(key) & (map->bucket_count - 1);
+}
+
+static hashmap_entry* hashmap_find(hashmap_t* map, const char* key) {
+    if (map->bucket_count == 0) {
+        return NULL;
+    }
+    for (hashmap_entry* entry = map->buckets[hashmap_bucket(map, key)]; entry; entry = entry->bucket_next) {
+        if (strcmp(entry->key, key) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+hashmap_t* hashmap_create() {
+    return calloc(1, sizeof(hashmap_t));
+}
+
+void* hashmap_get(hashmap_t* map, const char* key) {
+    hashmap_entry* entry = hashmap_find(map, key);
+    return entry ? entry->value : NULL;
+}
+
+void hashmap_put(hashmap_t* map, const char* key, void* value) {
+    hashmap_entry* entry = hashmap_find(map, key);
+    if (entry) {
+        entry->value = value;
+        return;
+    }
+    if (map->count >= map->bucket_count) {
+        free(map->buckets);
+        map->bucket_count = map->bucket_count ? map->bucket_count * 2 : 64;
+        map->buckets = calloc(map->bucket_count, sizeof(hashmap_entry*));
+        for (hashmap_entry* other = map->head; other; other = other->next) {
+            size_t bucket = hashmap_bucket(map, other->key);
+            other->bucket_next = map->buckets[bucket];
+            map->buckets[bucket] = other;
+        }
+    }
+    entry = calloc(1, sizeof(hashmap_entry));
+    entry->key = key;
+    entry->value = value;
+    size_t bucket = hashmap_bucket(map, key);
+    entry->bucket_next = map->buckets[bucket];
+    map->buckets[bucket] = entry;
+    if (map->tail) {
+        map->tail->next = entry;
+    } else {
+        map->head = entry;
+    }
+    map->tail = entry;
+    map->count++;
+}
+
+// grapha.c never removes keys; the stub only needs to link
+void hashmap_remove(hashmap_t* map, const char* key) {
+    (void)map;
+    (void)key;
+}
+
+void hashmap_destroy(hashmap_t* map) {
+    hashmap_entry* entry = map->head;
+    while (entry) {
+        hashmap_entry* next = entry->next;
+        free(entry);
+        entry = next;
+    }
+    free(map->buckets);
+    free(map);
+}
+
+void hashmap_free_values_and_destroy(hashmap_t* map) {
+    for (hashmap_entry* entry = map->head; entry; entry = entry->next) {
+        free(entry->value);
+    }
+    hashmap_destroy(map);
+}
+
+// --- Stress Driver ---
+
+#define STRESS_READS_PER_REGISTRATION 1000
+
+typedef struct {
+    VersionedGraph* versioned;
+    uint32_t publish_every;
+    _Atomic bool* done;
+    uint64_t reads;
+    bool ok;
+} StressReader;
+
+static bool version_is_consistent(const GraphVersion* version, uint32_t publish_every) {
+    const FrozenGraph* frozen = version->frozen;
+    if (frozen->edge_count != (version->number - 1) * publish_every) {
+        return false;
+    }
+    uint32_t slots = 0;
+    for (uint32_t v = 0; v < frozen->vertex_count; ++v) {
+        if (frozen->offsets[v + 1] < frozen->offsets[v]) {
+            return false;
+        }
+        slots += frozen->offsets[v + 1] - frozen->offsets[v];
+    }
+    if (slots != frozen->slot_count) {
+        return false;
+    }
+    for (uint32_t slot = 0; slot < frozen->slot_count; ++slot) {
+        if (frozen->targets[slot] >= frozen->vertex_count || frozen->slot_edge[slot] >= frozen->edge_count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void* stress_reader_main(void* arg) {
+    StressReader* stress = arg;
+    uint64_t last_number = 0;
+    while (!atomic_load(stress->done)) {
+        int reader = versioned_graph_register_reader(stress->versioned);
+        if (reader < 0) {
+            stress->ok = false;
+            return NULL;
+        }
+        for (int i = 0; i < STRESS_READS_PER_REGISTRATION && !atomic_load(stress->done); ++i) {
+            const GraphVersion* version = versioned_graph_read_begin(stress->versioned, reader);
+            if (version->number < last_number || !version_is_consistent(version, stress->publish_every)) {
+                stress->ok = false;
+            }
+            last_number = version->number;
+            versioned_graph_read_end(stress->versioned, reader);
+            stress->reads++;
+        }
+        versioned_graph_unregister_reader(stress->versioned, reader);
+    }
+    return NULL;
+}
+
+static bool run_stress(uint32_t reader_threads, uint32_t edge_count, uint32_t publish_every) {
+    if (reader_threads > VERSION_MAX_READERS) {
+        reader_threads = VERSION_MAX_READERS;
+    }
+    VersionedGraph* versioned = versioned_graph_create();
+    _Atomic bool done = false;
+    StressReader* readers = calloc(reader_threads + 1, sizeof(StressReader));
+    pthread_t* threads = calloc(reader_threads + 1, sizeof(pthread_t));
+    uint32_t started = 0;
+    for (; started < reader_threads; ++started) {
+        readers[started] = (StressReader){versioned, publish_every, &done, 0, true};
+        if (pthread_create(&threads[started], NULL, stress_reader_main, &readers[started]) != 0) {
+            break;
+        }
+    }
+
+    // Vertices are added as edges reach them; edge i joins i / 2 and i + 1
+    char source[32], target[32];
+    uint32_t vertex_count = 0;
+    uint32_t published = edge_count - edge_count % publish_every;
+    for (uint32_t i = 0; i < published; ++i) {
+        while (vertex_count <= i + 1) {
+            snprintf(source, sizeof(source), "v%u", vertex_count++);
+            graph_add_vertex(versioned->graph, source);
+        }
+        snprintf(source, sizeof(source), "v%u", i / 2);
+        snprintf(target, sizeof(target), "v%u", i + 1);
+        graph_add_edge(versioned->graph, source, target, true, 1.0, NULL);
+        if ((i + 1) % publish_every == 0) {
+            versioned_graph_publish(versioned);
+        }
+    }
+
+    atomic_store(&done, true);
+    bool ok = true;
+    uint64_t reads = 0;
+    for (uint32_t i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+        ok = ok && readers[i].ok;
+        reads += readers[i].reads;
+    }
+    // Every slot must be free again once the readers are gone
+    for (uint32_t i = 0; i < started; ++i) {
+        int reader = versioned_graph_register_reader(versioned);
+        ok = ok && reader >= 0 && (uint32_t)reader < started;
+    }
+    size_t pending = versioned_graph_reclaim(versioned);
+    printf("version stress: %u readers, %llu reads, %llu versions, %zu left to reclaim: %s\n", started,
+           (unsigned long long)reads, (unsigned long long)versioned->next_number, pending, ok ? "ok" : "FAILED");
+    free(readers);
+    free(threads);
+    versioned_graph_destroy(versioned);
+    return ok && pending == 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t readers = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 4;
+    uint32_t edges = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 1500;
+    uint32_t publish_every = argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 10) : 50;
+    if (publish_every == 0) {
+        publish_every = 1;
+    }
+    return run_stress(readers, edges, publish_every) ? 0 : 1;
+}
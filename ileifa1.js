@@ -19,6 +19,12 @@ function getCurrentGraph() {
     return graphs[currentGraphName];
 }
 
+// Called by every change to a graph's nodes, edges or directedness, so caches
+// derived from the graph (the native adjacency index) know when to rebuild
+function markGraphChanged(graphData) {
+    graphData.revision = (graphData.revision || 0) + 1;
+}
+
 // Command to initialize a default graph
 const defaultGraphCommands = `
 Create Node 0 VALUE 10.
@@ -142,6 +148,7 @@ function resetGraph() {
     graphData.edges = [];
     graphData.directed = false;
     graphData.weighted = false;
+    markGraphChanged(graphData);
     nodePositions.clear(); // Clear the visualization positions
     graphData.bgColor = '#f5f5f5'; // Reset background color
     canvasBgColor = graphData.bgColor; // Update global for compatibility
@@ -192,6 +199,7 @@ function createNode(id, value = null, type = 'undefined') {
         value: parsedValue,
         type: detectedType
     });
+    markGraphChanged(graphData);
 }
 
 // Control flow evaluation
@@ -355,28 +363,336 @@ class PriorityQueue {
 }
 
 /**
- * Depth-First Search (DFS) helper for cycle detection.
+ * Returns the compiled graph core (ilaifa0.c) when it has been loaded, or null.
+ * @returns {object|null} The Emscripten module exposing the graph algorithm exports.
+ */
+function getNativeCore() {
+    if (typeof Module !== 'undefined' && Module._buildAdjacencyIndex && Module.HEAP32) {
+        return Module;
+    }
+    return null;
+}
+
+/**
+ * Writes the graph's edges into the native core's edge list as index pairs and weights.
+ * @param {object} core The Emscripten module.
+ * @param {object} graphData The graph to copy.
+ * @returns {object|null} The node ids by native index (ids) and their inverse (indexOf),
+ *     or null if the core could not make room for the edges.
+ */
+function fillNativeEdgeList(core, graphData) {
+    const ids = graphData.nodes.map(node => node.id);
+    const indexOf = new Map(ids.map((id, index) => [id, index]));
+    const edgeCount = graphData.edges.length;
+    const pairsPtr = core._reserveEdgeList(edgeCount);
+    if (!pairsPtr) return null;
+    // Take the heap views after reserving, the call may have grown memory
+    const pairs = core.HEAP32.subarray(pairsPtr >> 2, (pairsPtr >> 2) + 2 * edgeCount);
+    const weightsPtr = core._getEdgeListWeightsPtr();
+    const weights = core.HEAPF64.subarray(weightsPtr >> 3, (weightsPtr >> 3) + edgeCount);
+    graphData.edges.forEach((edge, i) => {
+        pairs[2 * i] = indexOf.has(edge.source) ? indexOf.get(edge.source) : -1;
+        pairs[2 * i + 1] = indexOf.has(edge.target) ? indexOf.get(edge.target) : -1;
+        weights[i] = edge.weight ?? 1;
+    });
+    return { ids, indexOf };
+}
+
+// The graph last copied into the native adjacency index, with its revision and
+// the index generation the core reported after the copy. Other callers of the
+// core (buildAdjacencyIndexFromGraph(), the coloring benchmark) rebuild the
+// same index, which the generation catches.
+let nativeIndexCache = null;
+
+/**
+ * Copies the graph into the native core's adjacency index, unless the index
+ * already holds this revision of it.
+ * @param {object} core The Emscripten module.
+ * @param {object} graphData The graph to index.
+ * @returns {object|null} The node ids by native index (ids) and their inverse (indexOf),
+ *     or null if the core rejected the graph.
+ */
+function syncNativeGraph(core, graphData) {
+    const revision = graphData.revision || 0;
+    const cache = nativeIndexCache;
+    if (cache && cache.core === core && cache.graph === graphData && cache.revision === revision &&
+        cache.generation === core._getAdjacencyGeneration()) {
+        return cache;
+    }
+    nativeIndexCache = null;
+    const list = fillNativeEdgeList(core, graphData);
+    if (!list || core._buildAdjacencyIndex(list.ids.length, graphData.edges.length, graphData.directed ? 1 : 0) < 0) {
+        return null;
+    }
+    nativeIndexCache = {
+        core, graph: graphData, revision, generation: core._getAdjacencyGeneration(), ids: list.ids, indexOf: list.indexOf
+    };
+    return nativeIndexCache;
+}
+
+// The graph mirrored in the native dynamic graph for the editing commands.
+// While `pending` is set its edge array is behind the native one and is
+// rebuilt by flushNativeEdits() before anything else reads it. `edges` holds
+// the edge objects as loaded, indexed by the origins the core reports.
+let nativeEditMirror = null;
+
+/**
+ * Returns the native dynamic graph holding this revision of the graph, loading it if needed.
+ * @param {object} core The Emscripten module.
+ * @param {object} graphData The graph to edit.
+ * @returns {object|null} The node ids by native index (ids) and their inverse (indexOf),
+ *     or null if the core rejected the graph.
+ */
+function getNativeEditMirror(core, graphData) {
+    const revision = graphData.revision || 0;
+    const mirror = nativeEditMirror;
+    if (mirror && mirror.core === core && mirror.graph === graphData && mirror.revision === revision) {
+        return mirror;
+    }
+    flushNativeEdits();
+    nativeEditMirror = null;
+    const list = fillNativeEdgeList(core, graphData);
+    if (!list || core._loadDynamicGraphFromEdgeList(list.ids.length, graphData.edges.length) < 0) {
+        return null;
+    }
+    nativeEditMirror = {
+        core, graph: graphData, revision, ids: list.ids, indexOf: list.indexOf, edges: graphData.edges.slice(), pending: false
+    };
+    return nativeEditMirror;
+}
+
+/**
+ * Native index of a node in the edit mirror, or -1 (which the core rejects) if it has none.
+ * @param {object} mirror The edit mirror.
+ * @param {string} nodeId The node ID.
+ * @returns {number} The native index.
+ */
+function nativeNodeIndex(mirror, nodeId) {
+    return mirror.indexOf.has(nodeId) ? mirror.indexOf.get(nodeId) : -1;
+}
+
+/**
+ * Applies an editing command to the native dynamic graph when the core is loaded. The
+ * graph's edge array is left stale until flushNativeEdits(), so a run of edits costs
+ * O(degree) each plus one O(E) rebuild.
+ * @param {object} graphData The graph being edited.
+ * @param {Function} edit Called with (core, mirror); may throw the command's errors, and
+ *     returns false, leaving the native graph unchanged, if the core cannot apply the edit.
+ * @returns {boolean} True if the edit was applied natively. Otherwise the edge array is up
+ *     to date and the caller applies the edit to it.
+ */
+function applyNativeEdit(graphData, edit) {
+    const core = getNativeCore();
+    const mirror = core && core._loadDynamicGraphFromEdgeList ? getNativeEditMirror(core, graphData) : null;
+    if (mirror && edit(core, mirror)) {
+        mirror.pending = true;
+        markGraphChanged(graphData);
+        mirror.revision = graphData.revision;
+        return true;
+    }
+    flushNativeEdits();
+    return false;
+}
+
+/**
+ * Rebuilds the edited graph's edge array from the native dynamic graph, if it is behind.
+ * Each native edge comes back as the object it was loaded from, with only its endpoints
+ * updated, so weights and other fields survive as they were. The far half of a subdivided
+ * edge gets a copy of the original.
+ */
+function flushNativeEdits() {
+    const mirror = nativeEditMirror;
+    if (!mirror || !mirror.pending) return;
+    const core = mirror.core;
+    const count = core._exportDynamicEdgeList();
+    if (count < 0) throw new Error('Out of memory while applying graph edits.');
+    const pairsPtr = core._getEdgeListPairsPtr();
+    const pairs = core.HEAP32.subarray(pairsPtr >> 2, (pairsPtr >> 2) + 2 * count);
+    const weightsPtr = core._getEdgeListWeightsPtr();
+    const weights = core.HEAPF64.subarray(weightsPtr >> 3, (weightsPtr >> 3) + count);
+    const originsPtr = core._getDynamicEdgeOriginsPtr();
+    const origins = core.HEAP32.subarray(originsPtr >> 2, (originsPtr >> 2) + count);
+    const reused = new Set();
+    mirror.graph.edges = Array.from({ length: count }, (_, i) => {
+        const source = mirror.ids[pairs[2 * i]];
+        const target = mirror.ids[pairs[2 * i + 1]];
+        const original = origins[i] >= 0 ? mirror.edges[origins[i]] : undefined;
+        if (!original) return { source, target, weight: weights[i] };
+        const edge = reused.has(original) ? { ...original } : original;
+        reused.add(original);
+        edge.source = source;
+        edge.target = target;
+        return edge;
+    });
+    mirror.pending = false;
+}
+
+/**
+ * Shortest path through the native core: Dijkstra when weighted, otherwise BFS
+ * ignoring edge direction, matching dijkstra() and bfs() below.
+ * @param {string} startNodeId The ID of the starting node.
+ * @param {string} targetNodeId The ID of the target node.
+ * @param {boolean} weighted Whether to use edge weights.
+ * @returns {Array|null|undefined} The path, null if there is none, or undefined if the core is unavailable.
+ */
+function nativeShortestPath(startNodeId, targetNodeId, weighted) {
+    const core = getNativeCore();
+    if (!core) return undefined;
+    const index = syncNativeGraph(core, getCurrentGraph());
+    if (!index) return undefined;
+    const start = index.indexOf.get(startNodeId);
+    const end = index.indexOf.get(targetNodeId);
+    if (start === undefined || end === undefined) return null;
+    const length = weighted ? core._findPathDijkstra(start, end) : core._findPathBFS(start, end, 0);
+    if (length < 0) return undefined;
+    if (length === 0) return null;
+    const resultPtr = core._getResultIndicesPtr();
+    return Array.from(core.HEAP32.subarray(resultPtr >> 2, (resultPtr >> 2) + length), node => index.ids[node]);
+}
+
+/**
+ * Shortest path using the native core when available, falling back to the JS implementations.
+ * @param {string} startNodeId The ID of the starting node.
+ * @param {string} targetNodeId The ID of the target node.
+ * @param {boolean} weighted Whether to use edge weights.
+ * @returns {Array|null} An array representing the path, or null if no path is found.
+ */
+function findShortestPath(startNodeId, targetNodeId, weighted) {
+    const path = nativeShortestPath(startNodeId, targetNodeId, weighted);
+    if (path !== undefined) return path;
+    return weighted ? dijkstra(startNodeId, targetNodeId) : bfs(startNodeId, targetNodeId);
+}
+
+/**
+ * Connected components (ignoring edge direction), labelled by the native core when it is
+ * loaded and by repeated bfs() otherwise.
+ * @returns {Array} An array of components, each an array of node IDs.
+ */
+function findComponents() {
+    const graphData = getCurrentGraph();
+    const core = getNativeCore();
+    const list = core ? fillNativeEdgeList(core, graphData) : null;
+    if (list) {
+        const ids = list.ids;
+        const componentCount = core._labelEdgeListComponents(ids.length, graphData.edges.length);
+        if (componentCount >= 0) {
+            const idsPtr = core._getComponentIdsPtr();
+            const labels = core.HEAP32.subarray(idsPtr >> 2, (idsPtr >> 2) + ids.length);
+            const components = Array.from({ length: componentCount }, () => []);
+            labels.forEach((label, index) => components[label].push(ids[index]));
+            return components;
+        }
+    }
+
+    const visited = new Set();
+    const components = [];
+    for (const node of graphData.nodes) {
+        if (!visited.has(node.id)) {
+            const component = bfs(node.id);
+            components.push([...component]);
+            component.forEach(c => visited.add(c));
+        }
+    }
+    return components;
+}
+
+// Property bits returned by the native core's analyzeGraph()
+const GRAPH_PROPERTY = {
+    CONNECTED: 1 << 0,
+    ACYCLIC: 1 << 1,
+    TREE: 1 << 2,
+    BIPARTITE: 1 << 3,
+    REGULAR: 1 << 4,
+    COMPLETE: 1 << 5,
+    SIMPLE: 1 << 6
+};
+
+/**
+ * Computes every structural predicate of the current graph in one native pass.
+ * @returns {number|undefined} A GRAPH_PROPERTY bitmask, or undefined if the core is unavailable.
+ */
+function analyzeNativeGraph() {
+    const core = getNativeCore();
+    if (!core || !syncNativeGraph(core, getCurrentGraph())) return undefined;
+    const properties = core._analyzeGraph();
+    return properties < 0 ? undefined : properties;
+}
+
+// Coloring algorithms selectable from `Color GRAPH <name>` and
+// `Get CHROMATIC_NUMBER <name>`, with their ids in the native core
+const COLORING_ALGORITHMS = {
+    GREEDY: { id: 0, name: 'greedy' },
+    DSATUR: { id: 1, name: 'DSATUR' },
+    JP: { id: 2, name: 'Jones-Plassmann' }
+};
+
+/**
+ * Resolves an optional coloring algorithm argument.
+ * @param {string|undefined} token The algorithm name from the command, if any.
+ * @returns {string} A key of COLORING_ALGORITHMS.
+ */
+function resolveColoringAlgorithm(token) {
+    if (token === undefined) return 'GREEDY';
+    const key = token.toUpperCase();
+    if (!(key in COLORING_ALGORITHMS)) throw new Error(`Unknown coloring algorithm: ${token}`);
+    return key;
+}
+
+/**
+ * Colors the current graph with the native core.
+ * @param {string} algorithm A key of COLORING_ALGORITHMS.
+ * @returns {Object|undefined} An object mapping node IDs to colors, or undefined if the core is unavailable.
+ */
+function nativeColoring(algorithm) {
+    const core = getNativeCore();
+    if (!core) return undefined;
+    const index = syncNativeGraph(core, getCurrentGraph());
+    if (!index || core._colorGraph(COLORING_ALGORITHMS[algorithm].id) < 0) return undefined;
+    const ids = index.ids;
+    const colorsPtr = core._getColoringPtr();
+    const colors = core.HEAP32.subarray(colorsPtr >> 2, (colorsPtr >> 2) + ids.length);
+    const coloring = {};
+    ids.forEach((id, index) => { coloring[id] = colors[index]; });
+    return coloring;
+}
+
+/**
+ * Colors the current graph, natively when the core is loaded. Without it every
+ * algorithm falls back to the JS greedy coloring.
+ * @param {string} algorithm A key of COLORING_ALGORITHMS.
+ * @returns {Object} The coloring and the name of the algorithm that produced it.
+ */
+function colorGraphWith(algorithm) {
+    const coloring = nativeColoring(algorithm);
+    if (coloring) return { coloring, name: COLORING_ALGORITHMS[algorithm].name };
+    return { coloring: getColoring(), name: COLORING_ALGORITHMS.GREEDY.name };
+}
+
+/**
+ * Depth-First Search (DFS) helper for cycle detection. Only the edge that led here is
+ * skipped, so a second edge back to the parent counts as a cycle, as do loops, matching
+ * the native analyzeGraph().
  * @param {string} nodeId The current node ID.
  * @param {Set} visited A set of visited nodes.
  * @param {Set} recursionStack A set of nodes in the current recursion path.
- * @param {string|null} parentId The ID of the parent node.
+ * @param {object|null} parentEdge The edge this node was reached through.
  * @returns {boolean} True if a cycle is found, otherwise false.
  */
-function hasCycleDFS(nodeId, visited, recursionStack, parentId) {
+function hasCycleDFS(nodeId, visited, recursionStack, parentEdge) {
     const graphData = getCurrentGraph();
     visited.add(nodeId);
     recursionStack.add(nodeId);
 
-    const neighbors = graphData.edges
-        .filter(e => e.source === nodeId || e.target === nodeId)
-        .map(e => e.source === nodeId ? e.target : e.source);
+    const incidentEdges = graphData.edges.filter(e => e.source === nodeId || e.target === nodeId);
 
-    for (const neighborId of neighbors) {
+    for (const edge of incidentEdges) {
+        if (edge === parentEdge) continue;
+        const neighborId = edge.source === nodeId ? edge.target : edge.source;
         if (!visited.has(neighborId)) {
-            if (hasCycleDFS(neighborId, visited, recursionStack, nodeId)) {
+            if (hasCycleDFS(neighborId, visited, recursionStack, edge)) {
                 return true;
             }
-        } else if (recursionStack.has(neighborId) && neighborId !== parentId) {
+        } else if (recursionStack.has(neighborId)) {
             return true;
         }
     }
@@ -390,6 +706,8 @@ function hasCycleDFS(nodeId, visited, recursionStack, parentId) {
  * @returns {boolean} True if the graph is connected, otherwise false.
  */
 function isConnected() {
+    const properties = analyzeNativeGraph();
+    if (properties !== undefined) return (properties & GRAPH_PROPERTY.CONNECTED) !== 0;
     const graphData = getCurrentGraph();
     if (graphData.nodes.length === 0) return true;
     const startNodeId = graphData.nodes[0].id;
@@ -402,6 +720,8 @@ function isConnected() {
  * @returns {boolean} True if the graph has no cycles, otherwise false.
  */
 function isAcyclic() {
+    const properties = analyzeNativeGraph();
+    if (properties !== undefined) return (properties & GRAPH_PROPERTY.ACYCLIC) !== 0;
     const graphData = getCurrentGraph();
     const visited = new Set();
     for (const node of graphData.nodes) {
@@ -420,6 +740,8 @@ function isAcyclic() {
  * @returns {boolean} True if the graph is a tree, otherwise false.
  */
 function isTree() {
+    const properties = analyzeNativeGraph();
+    if (properties !== undefined) return (properties & GRAPH_PROPERTY.TREE) !== 0;
     return isConnected() && isAcyclic();
 }
 
@@ -436,6 +758,8 @@ function isForest() {
  * @returns {boolean} True if the graph is simple, otherwise false.
  */
 function isSimple() {
+    const properties = analyzeNativeGraph();
+    if (properties !== undefined) return (properties & GRAPH_PROPERTY.SIMPLE) !== 0;
     const graphData = getCurrentGraph();
     const seenEdges = new Set();
     for (const edge of graphData.edges) {
@@ -469,15 +793,17 @@ function getDegree(nodeId) {
  * @returns {boolean} True if the graph is regular, otherwise false.
  */
 function isRegular() {
+    const properties = analyzeNativeGraph();
+    if (properties !== undefined) return (properties & GRAPH_PROPERTY.REGULAR) !== 0;
     const graphData = getCurrentGraph();
     if (graphData.nodes.length <= 1) return true;
-    const firstDegree = getDegree(graphData.nodes[0].id);
-    for (const node of graphData.nodes) {
-        if (getDegree(node.id) !== firstDegree) {
-            return false;
-        }
+    const degrees = new Map(graphData.nodes.map(node => [node.id, 0]));
+    for (const edge of graphData.edges) {
+        degrees.set(edge.source, (degrees.get(edge.source) || 0) + 1);
+        if (edge.target !== edge.source) degrees.set(edge.target, (degrees.get(edge.target) || 0) + 1);
     }
-    return true;
+    const firstDegree = degrees.get(graphData.nodes[0].id);
+    return graphData.nodes.every(node => degrees.get(node.id) === firstDegree);
 }
 
 /**
@@ -485,6 +811,8 @@ function isRegular() {
  * @returns {boolean} True if the graph is complete, otherwise false.
  */
 function isComplete() {
+    const properties = analyzeNativeGraph();
+    if (properties !== undefined) return (properties & GRAPH_PROPERTY.COMPLETE) !== 0;
     const graphData = getCurrentGraph();
     const n = graphData.nodes.length;
     const m = graphData.edges.length;
@@ -511,6 +839,8 @@ function areAdjacent(id1, id2) {
  * @returns {boolean} True if the graph is bipartite, otherwise false.
  */
 function isBipartite() {
+    const properties = analyzeNativeGraph();
+    if (properties !== undefined) return (properties & GRAPH_PROPERTY.BIPARTITE) !== 0;
     const graphData = getCurrentGraph();
     const colors = {};
     for (const node of graphData.nodes) {
@@ -559,15 +889,19 @@ function getColoring() {
 }
 
 /**
- * Gets the chromatic number (greedy approximation).
+ * Gets the chromatic number (an upper bound from a coloring).
+ * @param {Object} colors A coloring to count; defaults to the greedy one.
  * @returns {number} The chromatic number.
  */
-function getChromaticNumber() {
-    const colors = getColoring();
+function getChromaticNumber(colors = getColoring()) {
     if (Object.keys(colors).length === 0) return 0;
     return Math.max(...Object.values(colors)) + 1;
 }
 
+// Commands applied through applyNativeEdit(); a run of them is flushed once
+const NATIVE_EDIT_COMMAND = /^(Remove EDGE|Isolate|Subdivide|Contract)\b/;
+let interpreterDepth = 0;
+
 /**
  * Enhanced interpreter with control flow and named graphs
  * @param {string} code The string containing the commands.
@@ -575,6 +909,7 @@ function getChromaticNumber() {
  */
 function interpretPenCode(code) {
     const lines = code.split('\n');
+    interpreterDepth++;
     let successCount = 0;
     let errorCount = 0;
     let lastMessage = '';
@@ -618,6 +953,9 @@ function interpretPenCode(code) {
         }
 
         try {
+            // Everything else may read the edge arrays
+            if (!NATIVE_EDIT_COMMAND.test(originalLine)) flushNativeEdits();
+
             // Handle control flow
             if (originalLine.startsWith('If ')) {
                 const conditionMatch = originalLine.match(/If (.+) \{/);
@@ -781,6 +1119,7 @@ function interpretPenCode(code) {
                         successCount++;
                     } else if (parts[1].toLowerCase() === 'directed') {
                         getCurrentGraph().directed = (parts[2] && parts[2].toLowerCase() === 'true');
+                        markGraphChanged(getCurrentGraph());
                         lastMessage = `Graph set to ${getCurrentGraph().directed ? 'directed' : 'undirected'}.`;
                         successCount++;
                     } else if (parts[1].toLowerCase() === 'weighted') {
@@ -814,6 +1153,7 @@ function interpretPenCode(code) {
                     }
                     
                     graphData.edges.push({ source: sourceId, target: targetId, weight });
+                    markGraphChanged(graphData);
                     lastMessage = `Connected node ${sourceId} to ${targetId}${graphData.weighted ? ` with weight ${weight}` : ''}.`;
                     successCount++;
                     break;
@@ -828,16 +1168,26 @@ function interpretPenCode(code) {
                             throw new Error(`Node ${nodeId} not found.`);
                         }
                         graphData.edges = graphData.edges.filter(edge => edge.source !== nodeId && edge.target !== nodeId);
+                        markGraphChanged(graphData);
                         lastMessage = `Removed node ${nodeId} and its incident edges.`;
                         successCount++;
                     } else if (parts[1] === 'EDGE') {
                         const sourceId = resolveValue(parts[2]);
                         const targetId = resolveValue(parts[4]);
                         const graphData = getCurrentGraph();
-                        const initialEdgeCount = graphData.edges.length;
-                        graphData.edges = graphData.edges.filter(edge => !(edge.source === sourceId && edge.target === targetId) && !(edge.target === sourceId && edge.source === targetId));
-                        if (graphData.edges.length === initialEdgeCount) {
-                            throw new Error(`Edge between ${sourceId} and ${targetId} not found.`);
+                        const removedNatively = applyNativeEdit(graphData, (core, mirror) => {
+                            if (core._dynamicRemoveEdgesBetween(nativeNodeIndex(mirror, sourceId), nativeNodeIndex(mirror, targetId)) <= 0) {
+                                throw new Error(`Edge between ${sourceId} and ${targetId} not found.`);
+                            }
+                            return true;
+                        });
+                        if (!removedNatively) {
+                            const initialEdgeCount = graphData.edges.length;
+                            graphData.edges = graphData.edges.filter(edge => !(edge.source === sourceId && edge.target === targetId) && !(edge.target === sourceId && edge.source === targetId));
+                            if (graphData.edges.length === initialEdgeCount) {
+                                throw new Error(`Edge between ${sourceId} and ${targetId} not found.`);
+                            }
+                            markGraphChanged(graphData);
                         }
                         lastMessage = `Removed edge between ${sourceId} and ${targetId}.`;
                         successCount++;
@@ -851,9 +1201,16 @@ function interpretPenCode(code) {
                     if (parts[1] === 'Node') {
                         const nodeId = resolveValue(parts[2]);
                         const graphData = getCurrentGraph();
-                        const nodeExists = graphData.nodes.some(n => n.id === nodeId);
-                        if (!nodeExists) throw new Error(`Node ${nodeId} not found.`);
-                        graphData.edges = graphData.edges.filter(edge => edge.source !== nodeId && edge.target !== nodeId);
+                        const isolatedNatively = applyNativeEdit(graphData, (core, mirror) => {
+                            if (!mirror.indexOf.has(nodeId)) throw new Error(`Node ${nodeId} not found.`);
+                            return core._dynamicIsolateNode(mirror.indexOf.get(nodeId)) >= 0;
+                        });
+                        if (!isolatedNatively) {
+                            const nodeExists = graphData.nodes.some(n => n.id === nodeId);
+                            if (!nodeExists) throw new Error(`Node ${nodeId} not found.`);
+                            graphData.edges = graphData.edges.filter(edge => edge.source !== nodeId && edge.target !== nodeId);
+                            markGraphChanged(graphData);
+                        }
                         lastMessage = `Isolated node ${nodeId}.`;
                         successCount++;
                     } else {
@@ -879,9 +1236,10 @@ function interpretPenCode(code) {
                 
                 case 'Color':
                     if (parts[1] === 'GRAPH') {
-                        const coloring = getColoring();
+                        const { coloring, name } = colorGraphWith(resolveColoringAlgorithm(parts[2]));
                         const output = Object.entries(coloring).map(([node, color]) => `${node}: Color ${color}`).join(', ');
-                        lastMessage = `Graph colored with a greedy algorithm: ${output}.`;
+                        const description = name === COLORING_ALGORITHMS.GREEDY.name ? 'a greedy algorithm' : name;
+                        lastMessage = `Graph colored with ${description}: ${output}.`;
                         successCount++;
                     }
                     break;
@@ -891,18 +1249,33 @@ function interpretPenCode(code) {
                     const targetSub = resolveValue(parts[3]);
                     const newNodeId = resolveValue(parts[5]);
                     const graphData = getCurrentGraph();
-                    const edgeToSubdivideIndex = graphData.edges.findIndex(e => (e.source === sourceSub && e.target === targetSub) || (e.source === targetSub && e.target === sourceSub));
-                    if (edgeToSubdivideIndex === -1) {
-                        throw new Error(`Edge between ${sourceSub} and ${targetSub} not found.`);
-                    }
-                    if (graphData.nodes.some(node => node.id === newNodeId)) {
-                        throw new Error(`New node ${newNodeId} already exists.`);
+                    const subdividedNatively = applyNativeEdit(graphData, (core, mirror) => {
+                        const edge = core._dynamicFindEdge(nativeNodeIndex(mirror, sourceSub), nativeNodeIndex(mirror, targetSub));
+                        if (edge < 0) throw new Error(`Edge between ${sourceSub} and ${targetSub} not found.`);
+                        if (mirror.indexOf.has(newNodeId)) throw new Error(`New node ${newNodeId} already exists.`);
+                        // Room for the extra edge flushNativeEdits() will read back
+                        if (!core._reserveEdgeList(core._getDynamicEdgeCount() + 1)) return false;
+                        const middle = core._dynamicSubdivide(edge, 0);
+                        if (middle < 0) return false;
+                        mirror.ids[middle] = newNodeId;
+                        mirror.indexOf.set(newNodeId, middle);
+                        return true;
+                    });
+                    if (!subdividedNatively) {
+                        const edgeToSubdivideIndex = graphData.edges.findIndex(e => (e.source === sourceSub && e.target === targetSub) || (e.source === targetSub && e.target === sourceSub));
+                        if (edgeToSubdivideIndex === -1) {
+                            throw new Error(`Edge between ${sourceSub} and ${targetSub} not found.`);
+                        }
+                        if (graphData.nodes.some(node => node.id === newNodeId)) {
+                            throw new Error(`New node ${newNodeId} already exists.`);
+                        }
+                        const edgeToSubdivide = graphData.edges.splice(edgeToSubdivideIndex, 1)[0];
+                        graphData.edges.push({ source: edgeToSubdivide.source, target: newNodeId, weight: edgeToSubdivide.weight });
+                        graphData.edges.push({ source: newNodeId, target: edgeToSubdivide.target, weight: edgeToSubdivide.weight });
+                        markGraphChanged(graphData);
                     }
-                    const edgeToSubdivide = graphData.edges.splice(edgeToSubdivideIndex, 1)[0];
                     const canvas = document.getElementById('graphCanvas');
                     graphData.nodes.push({ id: newNodeId, x: Math.random() * canvas.width, y: Math.random() * canvas.height, vx: 0, vy: 0, color: '#4a90e2' });
-                    graphData.edges.push({ source: edgeToSubdivide.source, target: newNodeId });
-                    graphData.edges.push({ source: newNodeId, target: edgeToSubdivide.target });
                     lastMessage = `Subdivided edge between ${sourceSub} and ${targetSub} with new node ${newNodeId}.`;
                     successCount++;
                     break;
@@ -911,14 +1284,31 @@ function interpretPenCode(code) {
                     const node1 = resolveValue(parts[1]);
                     const node2 = resolveValue(parts[2]);
                     const nodesToContract = [node1, node2];
-                    if (!areAdjacent(node1, node2)) {
-                        throw new Error('Cannot contract non-adjacent nodes.');
-                    }
-                    
                     const newId = `${node1}${node2}`;
                     const contractGraphData = getCurrentGraph();
-                    if (contractGraphData.nodes.some(node => node.id === newId)) {
-                        throw new Error(`New node ID ${newId} already exists.`);
+                    const contractedNatively = applyNativeEdit(contractGraphData, (core, mirror) => {
+                        const a = nativeNodeIndex(mirror, node1);
+                        const b = nativeNodeIndex(mirror, node2);
+                        if (core._dynamicFindEdge(a, b) < 0) throw new Error('Cannot contract non-adjacent nodes.');
+                        if (mirror.indexOf.has(newId)) throw new Error(`New node ID ${newId} already exists.`);
+                        if (a === b) return false;
+                        const kept = core._dynamicContract(a, b, 0);
+                        if (kept < 0) return false;
+                        // Loops at either node go too, as in the array path below
+                        core._dynamicRemoveEdgesBetween(kept, kept);
+                        mirror.indexOf.delete(node1);
+                        mirror.indexOf.delete(node2);
+                        mirror.ids[kept] = newId;
+                        mirror.indexOf.set(newId, kept);
+                        return true;
+                    });
+                    if (!contractedNatively) {
+                        if (!areAdjacent(node1, node2)) {
+                            throw new Error('Cannot contract non-adjacent nodes.');
+                        }
+                        if (contractGraphData.nodes.some(node => node.id === newId)) {
+                            throw new Error(`New node ID ${newId} already exists.`);
+                        }
                     }
 
                     const contractedNode = {
@@ -933,28 +1323,22 @@ function interpretPenCode(code) {
                     contractGraphData.nodes = contractGraphData.nodes.filter(node => !nodesToContract.includes(node.id));
                     contractGraphData.nodes.push(contractedNode);
                     
-                    contractGraphData.edges = contractGraphData.edges.filter(edge => !(nodesToContract.includes(edge.source) && nodesToContract.includes(edge.target)));
-                    
-                    contractGraphData.edges.forEach(edge => {
-                        if (edge.source === node1 || edge.source === node2) edge.source = newId;
-                        if (edge.target === node1 || edge.target === node2) edge.target = newId;
-                    });
+                    if (!contractedNatively) {
+                        contractGraphData.edges = contractGraphData.edges.filter(edge => !(nodesToContract.includes(edge.source) && nodesToContract.includes(edge.target)));
+                        
+                        contractGraphData.edges.forEach(edge => {
+                            if (edge.source === node1 || edge.source === node2) edge.source = newId;
+                            if (edge.target === node1 || edge.target === node2) edge.target = newId;
+                        });
+                        markGraphChanged(contractGraphData);
+                    }
                     
                     lastMessage = `Contracted nodes ${node1} and ${node2} into a new node ${newId}.`;
                     successCount++;
                     break;
 
                 case 'Partition':
-                    const visitedNodesForPartition = new Set();
-                    const components = [];
-                    const partitionGraphData = getCurrentGraph();
-                    for (const node of partitionGraphData.nodes) {
-                        if (!visitedNodesForPartition.has(node.id)) {
-                            const component = bfs(node.id);
-                            components.push(component);
-                            component.forEach(c => visitedNodesForPartition.add(c));
-                        }
-                    }
+                    const components = findComponents();
                     const componentList = components.map((comp, i) => `Component ${i+1}: ${[...comp].join(', ')}`).join('; ');
                     lastMessage = `Graph partitioned into ${components.length} components. Details: ${componentList}`;
                     successCount++;
@@ -970,15 +1354,16 @@ function interpretPenCode(code) {
                         lastMessage = `The degree of node ${nodeId} is ${degree}.`;
                         successCount++;
                     } else if (parts[1] === 'CHROMATIC_NUMBER') {
-                         const chromaticNumber = getChromaticNumber();
-                         lastMessage = `The chromatic number of the graph (greedy approximation) is ${chromaticNumber}.`;
+                         const { coloring, name } = colorGraphWith(resolveColoringAlgorithm(parts[2]));
+                         const chromaticNumber = getChromaticNumber(coloring);
+                         lastMessage = `The chromatic number of the graph (${name} approximation) is ${chromaticNumber}.`;
                          successCount++;
                     } else if (parts[1] === 'PATH') {
                          const start = resolveValue(parts[2]);
                          const end = resolveValue(parts[3]);
                          const pathGraphData = getCurrentGraph();
                          if (pathGraphData.weighted) {
-                             const path = dijkstra(start, end);
+                             const path = findShortestPath(start, end, true);
                              if (path) {
                                  lastMessage = `Shortest path (Dijkstra's): ${path.join(' -> ')}`;
                                  successCount++;
@@ -987,7 +1372,7 @@ function interpretPenCode(code) {
                                  errorCount++;
                              }
                          } else {
-                             const path = bfs(start, end);
+                             const path = findShortestPath(start, end, false);
                              if (path) {
                                   lastMessage = `Shortest path (BFS): ${path.join(' -> ')}`;
                                   successCount++;
@@ -997,16 +1382,7 @@ function interpretPenCode(code) {
                              }
                          }
                     } else if (parts[1] === 'COMPONENTS') {
-                        const visitedNodesForComponents = new Set();
-                        const components = [];
-                        const componentsGraphData = getCurrentGraph();
-                        for (const node of componentsGraphData.nodes) {
-                            if (!visitedNodesForComponents.has(node.id)) {
-                                const component = bfs(node.id);
-                                components.push([...component]);
-                                component.forEach(c => visitedNodesForComponents.add(c));
-                            }
-                        }
+                        const components = findComponents();
                         const output = components.map((comp, i) => `Component ${i + 1}: [${comp.join(', ')}]`).join(', ');
                         lastMessage = `Found ${components.length} connected components: ${output}`;
                         successCount++;
@@ -1028,6 +1404,7 @@ function interpretPenCode(code) {
         i++;
     }
 
+    if (--interpreterDepth === 0) flushNativeEdits();
     return {
       success: successCount,
       errors: errorCount,
@@ -2,6 +2,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+// Levels narrower than this run on the calling thread
+#define PARALLEL_MIN_LEVEL_WIDTH 2048
+#define PARALLEL_CHUNK_SIZE 256
+
+// Strings up to this length are stored inside the node itself
+#define SMALL_STRING_CAPACITY 15
 
 // --- Data Structures for the Graph ---
 
@@ -26,6 +38,17 @@ typedef enum {
     TYPE_UNKNOWN
 } ValueType;
 
+// A string value. Short text lives inline; longer text lives in a heap
+// block with slack on both sides, so repeated appends and prepends into the
+// same node are amortized linear. Read it through string_chars().
+typedef struct {
+    char* block;         // NULL while the text fits in small
+    int start;           // Offset of the text in block
+    int length;
+    int capacity;        // Size of block
+    char small[SMALL_STRING_CAPACITY + 1];
+} StringValue;
+
 // A node represents a data container in the graph.
 typedef struct {
     char* name;
@@ -33,7 +56,7 @@ typedef struct {
     union {
         int int_value;
         double double_value;
-        char* string_value;
+        StringValue string_value;
     } value;
     int is_output;
 } Node;
@@ -53,6 +76,79 @@ int num_nodes = 0;
 Edge* edges = NULL;
 int num_edges = 0;
 
+// Numeric edges are specialized into a kernel per operation and operand types
+#define NUMERIC_KERNEL(op, from_double, to_double) ((op) * 4 + (from_double) * 2 + (to_double))
+#define KERNEL_GENERIC NUMERIC_KERNEL(OP_UNKNOWN, 0, 0) // Strings and unknown ops
+#define KERNEL_COUNT (KERNEL_GENERIC + 1)
+
+// A stretch of scheduled edges that all use the same kernel
+typedef struct {
+    int kernel;
+    int begin;
+    int end;
+} KernelRun;
+
+// Execution schedule derived from the edges. Node names are resolved to
+// indices once, and edges are grouped into levels: every edge in a level only
+// depends on edges of earlier levels, so a level can run in parallel.
+typedef struct {
+    int* from_index;     // Per edge; -1 when the node does not exist
+    int* to_index;
+    int* order;          // Resolved edges, level by level
+    int* level_start;    // level_count + 1 offsets into order
+    int order_count;
+    int level_count;
+    int planned_nodes;   // Graph size the plan was built for
+    int planned_edges;
+    // Dependency index used by incremental re-execution, built on demand
+    int* position;       // Per edge; index into order, -1 when unresolved
+    int* reads_start;    // num_nodes + 1 offsets into reads
+    int* reads;          // Edges grouped by the node they read
+    int* writes_start;   // num_nodes + 1 offsets into writes
+    int* writes;         // Edges grouped by the node they update
+    int* last_writer;    // Per node; latest edge that updates it, or -1
+    // Typed specialization of order, valid while nodes start a pass with the
+    // types it was built for. Edges are regrouped by kernel within a level.
+    int* kernel_from;    // Per scheduled position
+    int* kernel_to;
+    int* kernel_edge;
+    KernelRun* runs;     // Cover order; only runs within narrow levels span levels
+    int run_count;
+    ValueType* kernel_types;
+} ExecutionPlan;
+
+ExecutionPlan plan = {0};
+
+// Incremental re-execution state. Declared values are the inputs a full
+// evaluation starts from; set_node_* changes them and marks the node dirty.
+Node* declared_values = NULL;   // Names are not copied
+int declared_count = 0;
+unsigned char* node_dirty = NULL;
+int* dirty_nodes = NULL;
+int dirty_count = 0;
+int dirty_capacity = 0;
+// Passes run since the values were last reset to the declared ones, or -1
+// when the graph changed after executing. Incremental recompute needs 1.
+int passes_since_reset = 0;
+
+// Persistent workers that help run wide levels
+typedef struct {
+    pthread_t* threads;
+    int thread_count;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    int generation;      // Bumped for every level handed out
+    int finished;        // Workers done with the current level
+    int shutting_down;
+    int level_begin;     // Scheduled positions of the current level
+    int level_end;
+    atomic_int next_item;
+} ThreadPool;
+
+ThreadPool pool = { .lock = PTHREAD_MUTEX_INITIALIZER, .work_ready = PTHREAD_COND_INITIALIZER, .work_done = PTHREAD_COND_INITIALIZER };
+int execution_thread_count = 0; // 0 = one per online CPU
+
 typedef enum {
     TOKEN_KEYWORD,
     TOKEN_PUNCTUATION,
@@ -63,109 +159,327 @@ typedef enum {
     TOKEN_UNKNOWN
 } TokenType;
 
+// A token is a view into the source passed to tokenize(), which must stay
+// alive while the tokens are in use.
 typedef struct {
     TokenType type;
-    char* value;
+    int offset;
+    int length;
 } Token;
 
 Token* tokens = NULL;
 int token_count = 0;
+int token_capacity = 0;
 int current_token_index = 0;
+const char* token_source = NULL;
 
-// --- Lexer (Tokenizer) Functions ---
+// Bump arena for token text that has to be NUL-terminated. Everything in it
+// is released at once by arena_free_all().
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t size;
+    char data[];
+} ArenaBlock;
 
-void tokenize(const char* input) {
-    if (tokens) {
-        for (int i = 0; i < token_count; i++) {
-            free(tokens[i].value);
+ArenaBlock* token_arena = NULL;
+
+// --- String Values ---
+
+const char* string_chars(const StringValue* string) {
+    return string->block ? string->block + string->start : string->small;
+}
+
+void string_set(StringValue* string, const char* text, int length) {
+    string->block = NULL;
+    string->start = 0;
+    string->capacity = 0;
+    string->length = length;
+    char* target = string->small;
+    if (length > SMALL_STRING_CAPACITY) {
+        string->block = (char*)malloc(length + 1);
+        string->capacity = length + 1;
+        target = string->block;
+    }
+    memcpy(target, text, length);
+    target[length] = '\0';
+}
+
+void string_free(StringValue* string) {
+    free(string->block);
+    string_set(string, "", 0);
+}
+
+// Ensures there is room for front_room more bytes before the text and
+// back_room more after it. Capacity at least doubles on every move, with the
+// spare space on the side that asked for it.
+void string_reserve(StringValue* string, int front_room, int back_room) {
+    if (string->block) {
+        if (string->start >= front_room && string->capacity - string->start - string->length - 1 >= back_room) { return; }
+    } else if (front_room == 0 && string->length + back_room <= SMALL_STRING_CAPACITY) {
+        return;
+    }
+    int needed = front_room + string->length + back_room + 1;
+    int capacity = string->capacity * 2;
+    if (capacity < 2 * (SMALL_STRING_CAPACITY + 1)) { capacity = 2 * (SMALL_STRING_CAPACITY + 1); }
+    if (capacity < needed) { capacity = needed; }
+    int start = front_room + (front_room > back_room ? capacity - needed : 0);
+    char* block = (char*)malloc(capacity);
+    memcpy(block + start, string_chars(string), string->length + 1);
+    free(string->block);
+    string->block = block;
+    string->start = start;
+    string->capacity = capacity;
+}
+
+// Offset of text inside the string's own storage, or -1 when it lies outside
+int string_alias_offset(const StringValue* string, const char* text) {
+    const char* chars = string_chars(string);
+    return (text >= chars && text <= chars + string->length) ? (int)(text - chars) : -1;
+}
+
+void string_append(StringValue* string, const char* text, int length) {
+    int alias = string_alias_offset(string, text);
+    string_reserve(string, 0, length);
+    char* chars = (char*)string_chars(string);
+    if (alias >= 0) { text = chars + alias; }
+    memmove(chars + string->length, text, length);
+    string->length += length;
+    chars[string->length] = '\0';
+}
+
+void string_prepend(StringValue* string, const char* text, int length) {
+    int alias = string_alias_offset(string, text);
+    if (!string->block && string->length + length <= SMALL_STRING_CAPACITY) {
+        char copy[SMALL_STRING_CAPACITY + 1];
+        memcpy(copy, text, length);
+        memmove(string->small + length, string->small, string->length + 1);
+        memcpy(string->small, copy, length);
+        string->length += length;
+        return;
+    }
+    string_reserve(string, length, 0);
+    if (alias >= 0) { text = string->block + string->start + alias; }
+    string->start -= length;
+    memmove(string->block + string->start, text, length);
+    string->length += length;
+}
+
+// Replaces the string with count copies of text in one sized allocation,
+// doubling the filled prefix with each copy. Returns 0 and leaves the string
+// unchanged when the result would be too long.
+int string_repeat(StringValue* string, const char* text, int length, int count) {
+    if (count > 0 && length > 0 && count > (INT_MAX - 1) / length) { return 0; }
+    StringValue result;
+    int total = (count > 0) ? length * count : 0;
+    string_set(&result, "", 0);
+    string_reserve(&result, 0, total);
+    char* chars = (char*)string_chars(&result);
+    if (total > 0) {
+        memcpy(chars, text, length);
+        for (int filled = length; filled < total; ) {
+            int chunk = (filled <= total - filled) ? filled : total - filled;
+            memcpy(chars + filled, chars, chunk);
+            filled += chunk;
         }
-        free(tokens);
-        tokens = NULL;
     }
+    chars[total] = '\0';
+    result.length = total;
+    free(string->block);
+    *string = result;
+    return 1;
+}
+
+// --- Token Storage Functions ---
+
+char* arena_alloc(size_t size) {
+    if (!token_arena || token_arena->size - token_arena->used < size) {
+        size_t block_size = 64 * 1024;
+        if (block_size < size) { block_size = size; }
+        ArenaBlock* block = (ArenaBlock*)malloc(sizeof(ArenaBlock) + block_size);
+        if (!block) { return NULL; }
+        block->next = token_arena;
+        block->used = 0;
+        block->size = block_size;
+        token_arena = block;
+    }
+    char* memory = token_arena->data + token_arena->used;
+    token_arena->used += size;
+    return memory;
+}
+
+void arena_free_all() {
+    while (token_arena) {
+        ArenaBlock* next = token_arena->next;
+        free(token_arena);
+        token_arena = next;
+    }
+}
+
+void free_tokens() {
+    free(tokens);
+    tokens = NULL;
     token_count = 0;
+    token_capacity = 0;
     current_token_index = 0;
+    arena_free_all();
+}
+
+// Grows the token array geometrically to hold at least `needed` tokens
+void reserve_tokens(int needed) {
+    if (needed <= token_capacity) { return; }
+    int new_capacity = token_capacity ? token_capacity : 1024;
+    while (new_capacity < needed) { new_capacity *= 2; }
+    Token* grown = (Token*)realloc(tokens, new_capacity * sizeof(Token));
+    if (!grown) {
+        fprintf(stderr, "Lexer error: Out of memory\n");
+        exit(1);
+    }
+    tokens = grown;
+    token_capacity = new_capacity;
+}
+
+void push_token(TokenType type, const char* start, int length) {
+    reserve_tokens(token_count + 1);
+    tokens[token_count].type = type;
+    tokens[token_count].offset = (int)(start - token_source);
+    tokens[token_count].length = length;
+    token_count++;
+}
+
+int token_is(const Token* token, const char* text) {
+    return token && (int)strlen(text) == token->length &&
+           memcmp(token_source + token->offset, text, token->length) == 0;
+}
+
+// NUL-terminated copy of a token's text, valid until the next tokenize()
+const char* token_text(const Token* token) {
+    if (!token) { return "EOF"; }
+    char* text = arena_alloc(token->length + 1);
+    if (!text) { return ""; }
+    memcpy(text, token_source + token->offset, token->length);
+    text[token->length] = '\0';
+    return text;
+}
+
+// Heap copy of a token's text for data that outlives the tokens
+char* token_strdup(const Token* token) {
+    char* text = (char*)malloc(token->length + 1);
+    memcpy(text, token_source + token->offset, token->length);
+    text[token->length] = '\0';
+    return text;
+}
+
+// --- Lexer (Tokenizer) Functions ---
+
+// Character classes, looked up once per byte through char_class[]
+enum {
+    CC_SPACE = 1,
+    CC_DIGIT = 2,          // Starts a number
+    CC_NUMBER = 4,         // Continues a number (digits and '.')
+    CC_IDENT_START = 8,
+    CC_IDENT = 16,         // Continues an identifier (letters, digits, '_')
+    CC_PUNCT = 32,
+    CC_QUOTE = 64
+};
+
+#define S CC_SPACE
+#define D (CC_DIGIT | CC_NUMBER | CC_IDENT)
+#define N CC_NUMBER
+#define A (CC_IDENT_START | CC_IDENT)
+#define P CC_PUNCT
+#define Q CC_QUOTE
+static const unsigned char char_class[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, S, S, S, S, S, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    S, 0, Q, 0, 0, P, 0, Q, P, P, P, P, P, P, N, P,
+    D, D, D, D, D, D, D, D, D, D, P, 0, 0, P, P, 0,
+    0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,
+    A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, A,
+    0, A, A, A, A, A, A, A, A, A, A, A, A, A, A, A,
+    A, A, A, A, A, A, A, A, A, A, A, P, 0, P, 0, 0,
+    // Bytes 128-255 are all class 0
+};
+#undef S
+#undef D
+#undef N
+#undef A
+#undef P
+#undef Q
+
+// Keyword test for a complete identifier: a switch on length and first
+// characters selects the single candidate, which one memcmp confirms.
+int is_keyword(const char* text, int length) {
+    const char* candidate = NULL;
+    switch (length) {
+        case 3: if (text[0] == 'i') { candidate = "int"; } break;
+        case 4:
+            switch (text[0]) {
+                case 'n': candidate = "node"; break;
+                case 'e': candidate = "edge"; break;
+                case 't': candidate = (text[1] == 'r') ? "true" : "type"; break;
+            }
+            break;
+        case 5: if (text[0] == 'f') { candidate = "false"; } break;
+        case 6:
+            switch (text[0]) {
+                case 'o': candidate = "output"; break;
+                case 'd': candidate = "double"; break;
+                case 's': candidate = "string"; break;
+            }
+            break;
+    }
+    return candidate && memcmp(text, candidate, length) == 0;
+}
+
+void tokenize(const char* input) {
+    free_tokens();
+    token_source = input;
 
     const char* p = input;
     while (*p) {
-        if (isspace((unsigned char)*p)) { p++; continue; }
+        unsigned char cls = char_class[(unsigned char)*p];
+        if (cls & CC_SPACE) { p++; continue; }
         if (*p == '/' && *(p+1) == '/') { while (*p && *p != '\n') { p++; } continue; }
-        
-        const char* keywords[] = {"node", "edge", "output", "true", "false", "type", "int", "double", "string"};
-        int is_keyword = 0;
-        for (int i = 0; i < 9; ++i) {
-            int len = strlen(keywords[i]);
-            if (strncmp(p, keywords[i], len) == 0 && !isalnum((unsigned char)p[len])) {
-                tokens = (Token*)realloc(tokens, (++token_count) * sizeof(Token));
-                tokens[token_count - 1].type = TOKEN_KEYWORD;
-                tokens[token_count - 1].value = strdup(keywords[i]);
-                p += len;
-                is_keyword = 1;
-                break;
-            }
+
+        if (cls & CC_IDENT_START) {
+            const char* start = p;
+            while (char_class[(unsigned char)*p] & CC_IDENT) { p++; }
+            push_token(is_keyword(start, p - start) ? TOKEN_KEYWORD : TOKEN_IDENTIFIER, start, p - start);
+            continue;
         }
-        if (is_keyword) continue;
-
-        if (*p == '{' || *p == '}' || *p == '(' || *p == ')' || *p == ':' || *p == ',' || *p == '>' || *p == '=' || *p == '+' || *p == '-' || *p == '*' || *p == '/' || *p == '%') {
-            tokens = (Token*)realloc(tokens, (++token_count) * sizeof(Token));
-            tokens[token_count - 1].type = TOKEN_PUNCTUATION;
-            tokens[token_count - 1].value = (char*)malloc(2);
-            tokens[token_count - 1].value[0] = *p;
-            tokens[token_count - 1].value[1] = '\0';
+
+        if (cls & CC_PUNCT) {
+            push_token(TOKEN_PUNCTUATION, p, 1);
             p++;
             continue;
         }
 
-        if (isdigit((unsigned char)*p) || (*p == '-' && isdigit((unsigned char)p[1]))) {
+        if (cls & CC_DIGIT) {
             const char* start = p;
-            p++;
-            while (isdigit((unsigned char)*p) || *p == '.') { p++; }
-            int len = p - start;
-            tokens = (Token*)realloc(tokens, (++token_count) * sizeof(Token));
-            tokens[token_count - 1].type = TOKEN_NUMBER;
-            tokens[token_count - 1].value = (char*)malloc(len + 1);
-            strncpy(tokens[token_count - 1].value, start, len);
-            tokens[token_count - 1].value[len] = '\0';
+            while (char_class[(unsigned char)*p] & CC_NUMBER) { p++; }
+            push_token(TOKEN_NUMBER, start, p - start);
             continue;
         }
 
-        if (*p == '\'' || *p == '"') {
-            char quote_char = *p;
-            const char* start = ++p;
-            while (*p && *p != quote_char) { p++; }
-            if (*p) {
-                int len = p - start;
-                tokens = (Token*)realloc(tokens, (++token_count) * sizeof(Token));
-                tokens[token_count - 1].type = TOKEN_STRING_LITERAL;
-                tokens[token_count - 1].value = (char*)malloc(len + 1);
-                strncpy(tokens[token_count - 1].value, start, len);
-                tokens[token_count - 1].value[len] = '\0';
-                p++;
+        if (cls & CC_QUOTE) {
+            const char* end = strchr(p + 1, *p);
+            if (end) {
+                push_token(TOKEN_STRING_LITERAL, p + 1, end - p - 1);
+                p = end + 1;
                 continue;
             }
         }
 
-        if (isalpha((unsigned char)*p) || *p == '_') {
-            const char* start = p;
-            while (isalnum((unsigned char)*p) || *p == '_') { p++; }
-            int len = p - start;
-            tokens = (Token*)realloc(tokens, (++token_count) * sizeof(Token));
-            tokens[token_count - 1].type = TOKEN_IDENTIFIER;
-            tokens[token_count - 1].value = (char*)malloc(len + 1);
-            strncpy(tokens[token_count - 1].value, start, len);
-            tokens[token_count - 1].value[len] = '\0';
-            continue;
-        }
-
-        tokens = (Token*)realloc(tokens, (++token_count) * sizeof(Token));
-        tokens[token_count - 1].type = TOKEN_UNKNOWN;
-        tokens[token_count - 1].value = (char*)malloc(2);
-        tokens[token_count - 1].value[0] = *p;
-        tokens[token_count - 1].value[1] = '\0';
+        // Unknown characters, including an unterminated quote
+        push_token(TOKEN_UNKNOWN, p, 1);
         p++;
     }
-    tokens = (Token*)realloc(tokens, (token_count + 1) * sizeof(Token));
+    // The EOF sentinel sits just past token_count
+    reserve_tokens(token_count + 1);
     tokens[token_count].type = TOKEN_EOF;
-    tokens[token_count].value = NULL;
+    tokens[token_count].offset = (int)(p - token_source);
+    tokens[token_count].length = 0;
 }
 
 // --- Parser Functions ---
@@ -182,8 +496,8 @@ Token* consume() {
 
 Token* expect_token(const char* expected_value) {
     Token* token = consume();
-    if (!token || strcmp(token->value, expected_value) != 0) {
-        fprintf(stderr, "Parsing error: Expected '%s', but got '%s'\n", expected_value, token ? token->value : "EOF");
+    if (!token_is(token, expected_value)) {
+        fprintf(stderr, "Parsing error: Expected '%s', but got '%s'\n", expected_value, token_text(token));
         return NULL;
     }
     return token;
@@ -198,34 +512,35 @@ void parse_node() {
     int is_output = 0;
     
     Node temp_node;
+    memset(&temp_node, 0, sizeof(temp_node));
     temp_node.value_type = TYPE_UNKNOWN;
 
-    while (peek() && strcmp(peek()->value, "}") != 0) {
+    while (peek() && !token_is(peek(), "}")) {
         Token* key = consume();
-        if (strcmp(key->value, "name") == 0) {
+        if (token_is(key, "name")) {
             expect_token(":");
             Token* name_token = consume();
             if (name_token && name_token->type == TOKEN_IDENTIFIER) {
-                name = strdup(name_token->value);
+                name = token_strdup(name_token);
             }
-        } else if (strcmp(key->value, "type") == 0) {
+        } else if (token_is(key, "type")) {
             expect_token(":");
             Token* type_token = consume();
-            if (strcmp(type_token->value, "int") == 0) { type = TYPE_INT; }
-            else if (strcmp(type_token->value, "double") == 0) { type = TYPE_DOUBLE; }
-            else if (strcmp(type_token->value, "string") == 0) { type = TYPE_STRING; }
-        } else if (strcmp(key->value, "value") == 0) {
+            if (token_is(type_token, "int")) { type = TYPE_INT; }
+            else if (token_is(type_token, "double")) { type = TYPE_DOUBLE; }
+            else if (token_is(type_token, "string")) { type = TYPE_STRING; }
+        } else if (token_is(key, "value")) {
             expect_token(":");
             Token* value_token = consume();
-            if (type == TYPE_INT) { temp_node.value.int_value = atoi(value_token->value); }
-            else if (type == TYPE_DOUBLE) { temp_node.value.double_value = atof(value_token->value); }
-            else if (type == TYPE_STRING) { temp_node.value.string_value = strdup(value_token->value); }
+            if (type == TYPE_INT) { temp_node.value.int_value = atoi(token_text(value_token)); }
+            else if (type == TYPE_DOUBLE) { temp_node.value.double_value = atof(token_text(value_token)); }
+            else if (type == TYPE_STRING && value_token) { string_set(&temp_node.value.string_value, token_source + value_token->offset, value_token->length); }
             else { fprintf(stderr, "Parsing error: 'type' must be specified before 'value'\n"); }
-        } else if (strcmp(key->value, "is_output") == 0) {
+        } else if (token_is(key, "is_output")) {
             expect_token(":");
-            is_output = (strcmp(consume()->value, "true") == 0);
+            is_output = token_is(consume(), "true");
         }
-        if (peek() && strcmp(peek()->value, ",") == 0) {
+        if (token_is(peek(), ",")) {
             consume();
         }
     }
@@ -252,19 +567,19 @@ void parse_edge() {
     char* to_node_name = NULL;
     char* op_str = NULL;
     
-    while (peek() && strcmp(peek()->value, "}") != 0) {
+    while (peek() && !token_is(peek(), "}")) {
         Token* key = consume();
-        if (strcmp(key->value, "from") == 0) {
+        if (token_is(key, "from")) {
             expect_token(":");
-            from_node_name = strdup(consume()->value);
-        } else if (strcmp(key->value, "to") == 0) {
+            from_node_name = token_strdup(consume());
+        } else if (token_is(key, "to")) {
             expect_token(":");
-            to_node_name = strdup(consume()->value);
-        } else if (strcmp(key->value, "op") == 0) {
+            to_node_name = token_strdup(consume());
+        } else if (token_is(key, "op")) {
             expect_token(":");
-            op_str = strdup(consume()->value);
+            op_str = token_strdup(consume());
         }
-        if (peek() && strcmp(peek()->value, ",") == 0) {
+        if (token_is(peek(), ",")) {
             consume();
         }
     }
@@ -293,12 +608,12 @@ void parse_edge() {
 
 void parse_program() {
     while (peek() && peek()->type != TOKEN_EOF) {
-        if (strcmp(peek()->value, "node") == 0) {
+        if (token_is(peek(), "node")) {
             parse_node();
-        } else if (strcmp(peek()->value, "edge") == 0) {
+        } else if (token_is(peek(), "edge")) {
             parse_edge();
         } else {
-            fprintf(stderr, "Parsing error: Unexpected token '%s'\n", peek()->value);
+            fprintf(stderr, "Parsing error: Unexpected token '%s'\n", token_text(peek()));
             consume();
         }
     }
@@ -313,125 +628,758 @@ Node* find_node(const char* name) {
     return NULL;
 }
 
-// The core execution engine for the graph
-void execute_graph() {
-    for (int i = 0; i < num_edges; ++i) {
-        Edge current_edge = edges[i];
-        Node* from = find_node(current_edge.from_node_name);
-        Node* to = find_node(current_edge.to_node_name);
+// Formats an int or double node the way string concatenation shows it
+int format_number(char* buffer, size_t size, const Node* node) {
+    if (node->value_type == TYPE_INT) { return snprintf(buffer, size, "%d", node->value.int_value); }
+    return snprintf(buffer, size, "%f", node->value.double_value);
+}
 
-        if (!from || !to) {
-            fprintf(stderr, "Execution error: Node not found for edge from '%s' to '%s'\n", current_edge.from_node_name, current_edge.to_node_name);
-            continue;
-        }
+// --- Typed Kernels ---
 
-        switch (current_edge.operation) {
-            case OP_ADD: {
-                if (from->value_type == TYPE_STRING || to->value_type == TYPE_STRING) {
-                    // String concatenation
-                    char* result_str;
-                    if (from->value_type == TYPE_STRING && to->value_type == TYPE_STRING) {
-                        int len = strlen(from->value.string_value) + strlen(to->value.string_value) + 1;
-                        result_str = (char*)malloc(len);
-                        strcpy(result_str, from->value.string_value);
-                        strcat(result_str, to->value.string_value);
-                    } else if (from->value_type == TYPE_STRING) {
-                        char temp_str[100]; // Buffer for number
-                        sprintf(temp_str, (to->value_type == TYPE_INT) ? "%d" : "%f", (to->value_type == TYPE_INT) ? to->value.int_value : to->value.double_value);
-                        int len = strlen(from->value.string_value) + strlen(temp_str) + 1;
-                        result_str = (char*)malloc(len);
-                        strcpy(result_str, from->value.string_value);
-                        strcat(result_str, temp_str);
-                    } else { // to is a string
-                         char temp_str[100]; // Buffer for number
-                        sprintf(temp_str, (from->value_type == TYPE_INT) ? "%d" : "%f", (from->value_type == TYPE_INT) ? from->value.int_value : from->value.double_value);
-                        int len = strlen(temp_str) + strlen(to->value.string_value) + 1;
-                        result_str = (char*)malloc(len);
-                        strcpy(result_str, temp_str);
-                        strcat(result_str, to->value.string_value);
-                    }
-                    if (to->value_type == TYPE_STRING && to->value.string_value) free(to->value.string_value);
+// Picks the kernel for an edge from its operand types. Non-string operands
+// other than int are read as doubles, and any double makes the result one.
+int select_kernel(EdgeOperation operation, ValueType from_type, ValueType to_type) {
+    if (operation == OP_UNKNOWN || from_type == TYPE_STRING || to_type == TYPE_STRING) { return KERNEL_GENERIC; }
+    return NUMERIC_KERNEL(operation, from_type != TYPE_INT, to_type != TYPE_INT);
+}
+
+// Type of the target node after an edge runs
+ValueType kernel_result_type(int kernel, EdgeOperation operation, ValueType from_type, ValueType to_type) {
+    if (kernel != KERNEL_GENERIC) { return (from_type == TYPE_INT && to_type == TYPE_INT) ? TYPE_INT : TYPE_DOUBLE; }
+    if ((operation == OP_ADD || operation == OP_MUL) && (from_type == TYPE_STRING || to_type == TYPE_STRING)) { return TYPE_STRING; }
+    return to_type;
+}
+
+#define KERNEL_LOOP(TYPE, FROM_FIELD, TO_FIELD, RESULT_TYPE, RESULT_FIELD, EXPR) \
+    for (int i = 0; i < count; ++i) { \
+        TYPE f = (TYPE)nodes[from_index[i]].value.FROM_FIELD; \
+        Node* target = &nodes[to_index[i]]; \
+        TYPE t = (TYPE)target->value.TO_FIELD; \
+        (void)f; \
+        target->value_type = RESULT_TYPE; \
+        target->value.RESULT_FIELD = (EXPR); \
+    } \
+    break;
+
+#define NUMERIC_KERNEL_CASES(OP, INT_EXPR, DOUBLE_EXPR) \
+    case NUMERIC_KERNEL(OP, 0, 0): KERNEL_LOOP(int, int_value, int_value, TYPE_INT, int_value, INT_EXPR) \
+    case NUMERIC_KERNEL(OP, 0, 1): KERNEL_LOOP(double, int_value, double_value, TYPE_DOUBLE, double_value, DOUBLE_EXPR) \
+    case NUMERIC_KERNEL(OP, 1, 0): KERNEL_LOOP(double, double_value, int_value, TYPE_DOUBLE, double_value, DOUBLE_EXPR) \
+    case NUMERIC_KERNEL(OP, 1, 1): KERNEL_LOOP(double, double_value, double_value, TYPE_DOUBLE, double_value, DOUBLE_EXPR)
+
+// Runs count edges through one numeric kernel. Int kernels wrap on
+// overflow, and division or modulo by zero gives 0.
+void run_kernel(int kernel, const int* from_index, const int* to_index, int count) {
+    switch (kernel) {
+        NUMERIC_KERNEL_CASES(OP_ADD, (int)((unsigned)t + (unsigned)f), f + t)
+        NUMERIC_KERNEL_CASES(OP_SUB, (int)((unsigned)t - (unsigned)f), t - f)
+        NUMERIC_KERNEL_CASES(OP_MUL, (int)((unsigned)t * (unsigned)f), f * t)
+        NUMERIC_KERNEL_CASES(OP_DIV, (f == 0) ? 0 : (f == -1) ? (int)(0u - (unsigned)t) : t / f, (f != 0) ? t / f : 0)
+        NUMERIC_KERNEL_CASES(OP_MOD, (f == 0 || f == -1) ? 0 : t % f, ((int)f == 0 || (int)f == -1) ? 0 : (double)((int)t % (int)f))
+        NUMERIC_KERNEL_CASES(OP_INC, (int)((unsigned)t + 1u), t + 1)
+        NUMERIC_KERNEL_CASES(OP_DEC, (int)((unsigned)t - 1u), t - 1)
+        NUMERIC_KERNEL_CASES(OP_EQUALS, t == f, (t == f) ? 1.0 : 0.0)
+        default: break;
+    }
+}
+
+// Runs a single numeric edge through the kernel for its current types
+void run_numeric_edge(const Edge* edge, Node* from, Node* to) {
+    int from_index = (int)(from - nodes), to_index = (int)(to - nodes);
+    run_kernel(select_kernel(edge->operation, from->value_type, to->value_type), &from_index, &to_index, 1);
+}
+
+// Applies one edge's operation to its target node
+void execute_edge(const Edge* edge, Node* from, Node* to) {
+    switch (edge->operation) {
+        case OP_ADD: {
+            if (from->value_type == TYPE_STRING || to->value_type == TYPE_STRING) {
+                // String concatenation: to = from + to
+                if (from->value_type == TYPE_STRING && to->value_type == TYPE_STRING) {
+                    string_prepend(&to->value.string_value, string_chars(&from->value.string_value), from->value.string_value.length);
+                } else if (from->value_type == TYPE_STRING) {
+                    char number_text[64];
+                    int number_length = format_number(number_text, sizeof(number_text), to);
+                    StringValue result;
+                    string_set(&result, string_chars(&from->value.string_value), from->value.string_value.length);
+                    string_append(&result, number_text, number_length);
                     to->value_type = TYPE_STRING;
-                    to->value.string_value = result_str;
-                } else {
-                    // Numeric addition
-                    double from_val = (from->value_type == TYPE_INT) ? (double)from->value.int_value : from->value.double_value;
-                    double to_val = (to->value_type == TYPE_INT) ? (double)to->value.int_value : to->value.double_value;
-                    if (to->value_type == TYPE_INT && from->value_type == TYPE_INT) {
-                        to->value.int_value = (int)(from_val + to_val);
-                    } else {
-                        to->value_type = TYPE_DOUBLE;
-                        to->value.double_value = from_val + to_val;
-                    }
+                    to->value.string_value = result;
+                } else { // to is a string
+                    char number_text[64];
+                    int number_length = format_number(number_text, sizeof(number_text), from);
+                    string_prepend(&to->value.string_value, number_text, number_length);
                 }
                 break;
             }
-            case OP_MUL: {
-                if (from->value_type == TYPE_STRING || to->value_type == TYPE_STRING) {
-                    char* string_to_repeat = (from->value_type == TYPE_STRING) ? from->value.string_value : to->value.string_value;
-                    double repeat_count = (from->value_type == TYPE_STRING) ? (to->value_type == TYPE_INT) ? (double)to->value.int_value : to->value.double_value : (from->value_type == TYPE_INT) ? (double)from->value.int_value : from->value.double_value;
-                    
-                    if (to->value_type == TYPE_STRING && to->value.string_value) free(to->value.string_value);
-                    
-                    int initial_len = strlen(string_to_repeat);
-                    int total_len = initial_len * (int)repeat_count + 1;
-                    char* result_str = (char*)malloc(total_len);
-                    result_str[0] = '\0';
-                    for (int j = 0; j < (int)repeat_count; j++) {
-                        strcat(result_str, string_to_repeat);
-                    }
-                    to->value_type = TYPE_STRING;
-                    to->value.string_value = result_str;
-                } else {
-                    // Numeric multiplication
-                    double from_val = (from->value_type == TYPE_INT) ? (double)from->value.int_value : from->value.double_value;
-                    double to_val = (to->value_type == TYPE_INT) ? (double)to->value.int_value : to->value.double_value;
-                    if (to->value_type == TYPE_INT && from->value_type == TYPE_INT) {
-                        to->value.int_value = (int)(from_val * to_val);
-                    } else {
-                        to->value_type = TYPE_DOUBLE;
-                        to->value.double_value = from_val * to_val;
-                    }
+            run_numeric_edge(edge, from, to);
+            break;
+        }
+        case OP_MUL: {
+            if (from->value_type == TYPE_STRING || to->value_type == TYPE_STRING) {
+                // Repeat the string operand by the other operand; a string
+                // count repeats zero times
+                const Node* text = (from->value_type == TYPE_STRING) ? from : to;
+                const Node* count = (text == from) ? to : from;
+                int repeat_count = (count->value_type == TYPE_INT) ? count->value.int_value :
+                                   (count->value_type == TYPE_DOUBLE) ? (int)count->value.double_value : 0;
+                if (to->value_type != TYPE_STRING) { string_set(&to->value.string_value, "", 0); }
+                to->value_type = TYPE_STRING;
+                if (!string_repeat(&to->value.string_value, string_chars(&text->value.string_value), text->value.string_value.length, repeat_count)) {
+                    fprintf(stderr, "Execution Error: String repetition result is too long.\n");
                 }
                 break;
             }
-            // For other operations, handle only numeric types and give errors for strings
-            case OP_SUB:
-            case OP_DIV:
-            case OP_MOD:
-            case OP_INC:
-            case OP_DEC:
-            case OP_EQUALS:
-                if (from->value_type == TYPE_STRING || to->value_type == TYPE_STRING) {
-                    fprintf(stderr, "Execution Error: Cannot perform numeric operation on a string value.\n");
-                    continue;
-                }
-                double from_val = (from->value_type == TYPE_INT) ? (double)from->value.int_value : from->value.double_value;
-                double to_val = (to->value_type == TYPE_INT) ? (double)to->value.int_value : to->value.double_value;
-                switch (current_edge.operation) {
-                    case OP_SUB: to->value.double_value = to_val - from_val; break;
-                    case OP_DIV: to->value.double_value = (from_val != 0) ? to_val / from_val : 0; break;
-                    case OP_MOD: to->value.int_value = (int)to_val % (int)from_val; break;
-                    case OP_INC: to->value.double_value = to_val + 1; break;
-                    case OP_DEC: to->value.double_value = to_val - 1; break;
-                    case OP_EQUALS: to->value.int_value = (to_val == from_val) ? 1 : 0; break;
-                    default: break;
-                }
-                if (to->value_type == TYPE_INT && from->value_type == TYPE_INT) {
-                     // Keep type as int if both were int
-                } else {
-                    to->value_type = TYPE_DOUBLE;
+            run_numeric_edge(edge, from, to);
+            break;
+        }
+        // For other operations, handle only numeric types and give errors for strings
+        case OP_SUB:
+        case OP_DIV:
+        case OP_MOD:
+        case OP_INC:
+        case OP_DEC:
+        case OP_EQUALS:
+            if (from->value_type == TYPE_STRING || to->value_type == TYPE_STRING) {
+                fprintf(stderr, "Execution Error: Cannot perform numeric operation on a string value.\n");
+                return;
+            }
+            run_numeric_edge(edge, from, to);
+            break;
+        default:
+            fprintf(stderr, "Execution Error: Unknown operation '%s'\n", edge->function_name);
+            break;
+    }
+}
+
+// --- Execution Planning ---
+
+unsigned int hash_name(const char* name) {
+    unsigned int hash = 2166136261u;
+    while (*name) {
+        hash ^= (unsigned char)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void free_execution_plan() {
+    free(plan.from_index);
+    free(plan.to_index);
+    free(plan.order);
+    free(plan.level_start);
+    free(plan.position);
+    free(plan.reads_start);
+    free(plan.reads);
+    free(plan.writes_start);
+    free(plan.writes);
+    free(plan.last_writer);
+    free(plan.kernel_from);
+    free(plan.kernel_to);
+    free(plan.kernel_edge);
+    free(plan.runs);
+    free(plan.kernel_types);
+    memset(&plan, 0, sizeof(plan));
+}
+
+// Resolves every edge's endpoints through a temporary open-addressing table
+void resolve_edge_endpoints() {
+    int slot_count = 16;
+    while (slot_count < 2 * num_nodes) { slot_count *= 2; }
+    int* slots = (int*)calloc(slot_count, sizeof(int)); // node index + 1
+    unsigned int mask = slot_count - 1;
+    for (int i = 0; i < num_nodes; ++i) {
+        unsigned int slot = hash_name(nodes[i].name) & mask;
+        while (slots[slot]) { slot = (slot + 1) & mask; }
+        slots[slot] = i + 1;
+    }
+
+    for (int e = 0; e < num_edges; ++e) {
+        const char* names[2] = { edges[e].from_node_name, edges[e].to_node_name };
+        int* targets[2] = { &plan.from_index[e], &plan.to_index[e] };
+        for (int k = 0; k < 2; ++k) {
+            *targets[k] = -1;
+            for (unsigned int slot = hash_name(names[k]) & mask; slots[slot]; slot = (slot + 1) & mask) {
+                if (strcmp(nodes[slots[slot] - 1].name, names[k]) == 0) {
+                    *targets[k] = slots[slot] - 1;
+                    break;
                 }
-                break;
-            default:
-                fprintf(stderr, "Execution Error: Unknown operation '%s'\n", current_edge.function_name);
-                break;
+            }
         }
     }
+    free(slots);
+}
+
+// Builds the level schedule. An edge reads its `from` node and updates its
+// `to` node, so following from -> to in declaration order it must run after
+// the last earlier edge that wrote either node, and after every earlier edge
+// that read its `to` node. Its level is one more than the latest of those.
+// Within a level edges keep declaration order, which includes edges that
+// share a target, so results match a sequential run exactly.
+void build_execution_plan() {
+    free_execution_plan();
+    plan.from_index = (int*)malloc((num_edges + 1) * sizeof(int));
+    plan.to_index = (int*)malloc((num_edges + 1) * sizeof(int));
+    plan.order = (int*)malloc((num_edges + 1) * sizeof(int));
+    int* edge_level = (int*)malloc((num_edges + 1) * sizeof(int));
+    int* last_write = (int*)calloc(num_nodes + 1, sizeof(int));
+    int* last_read = (int*)calloc(num_nodes + 1, sizeof(int));
+    resolve_edge_endpoints();
+
+    for (int e = 0; e < num_edges; ++e) {
+        int from = plan.from_index[e], to = plan.to_index[e];
+        if (from < 0 || to < 0) { edge_level[e] = 0; continue; }
+        int level = last_write[from];
+        if (last_write[to] > level) { level = last_write[to]; }
+        if (last_read[to] > level) { level = last_read[to]; }
+        level++;
+        edge_level[e] = level;
+        last_write[to] = level;
+        if (level > last_read[from]) { last_read[from] = level; }
+        if (level > plan.level_count) { plan.level_count = level; }
+    }
+
+    // Counting sort by level; stable, so declaration order is kept per level
+    plan.level_start = (int*)calloc(plan.level_count + 2, sizeof(int));
+    for (int e = 0; e < num_edges; ++e) {
+        if (edge_level[e] > 0) { plan.level_start[edge_level[e]]++; }
+    }
+    for (int l = 1; l <= plan.level_count + 1; ++l) { plan.level_start[l] += plan.level_start[l - 1]; }
+    for (int e = 0; e < num_edges; ++e) {
+        if (edge_level[e] > 0) { plan.order[plan.level_start[edge_level[e] - 1]++] = e; }
+    }
+    for (int l = plan.level_count; l > 0; --l) { plan.level_start[l] = plan.level_start[l - 1]; }
+    plan.level_start[0] = 0;
+    plan.order_count = plan.level_start[plan.level_count];
+
+    plan.planned_nodes = num_nodes;
+    plan.planned_edges = num_edges;
+    free(edge_level);
+    free(last_write);
+    free(last_read);
+}
+
+void ensure_execution_plan() {
+    if (!plan.order || plan.planned_nodes != num_nodes || plan.planned_edges != num_edges) {
+        build_execution_plan();
+        if (passes_since_reset != 0) { passes_since_reset = -1; }
+    }
+}
+
+// Assigns every scheduled edge its kernel by following node types through
+// the schedule, then regroups each level by kernel into runs
+void specialize_plan() {
+    free(plan.kernel_from);
+    free(plan.kernel_to);
+    free(plan.kernel_edge);
+    free(plan.runs);
+    free(plan.kernel_types);
+    plan.kernel_from = (int*)malloc((plan.order_count + 1) * sizeof(int));
+    plan.kernel_to = (int*)malloc((plan.order_count + 1) * sizeof(int));
+    plan.kernel_edge = (int*)malloc((plan.order_count + 1) * sizeof(int));
+    plan.runs = (KernelRun*)malloc((plan.order_count + 1) * sizeof(KernelRun));
+    plan.run_count = 0;
+    plan.kernel_types = (ValueType*)malloc((num_nodes + 1) * sizeof(ValueType));
+    ValueType* types = (ValueType*)malloc((num_nodes + 1) * sizeof(ValueType));
+    int* kernel_of = (int*)malloc((plan.order_count + 1) * sizeof(int));
+    for (int i = 0; i < num_nodes; ++i) { plan.kernel_types[i] = types[i] = nodes[i].value_type; }
+
+    for (int p = 0; p < plan.order_count; ++p) {
+        int e = plan.order[p];
+        ValueType from_type = types[plan.from_index[e]], to_type = types[plan.to_index[e]];
+        kernel_of[p] = select_kernel(edges[e].operation, from_type, to_type);
+        types[plan.to_index[e]] = kernel_result_type(kernel_of[p], edges[e].operation, from_type, to_type);
+    }
+
+    // Edges of a level are independent, so each level is counting-sorted by
+    // kernel. Consecutive narrow levels run in order on one thread, so a run
+    // may continue from one into the next.
+    int previous_narrow = 0;
+    for (int l = 0; l < plan.level_count; ++l) {
+        int begin = plan.level_start[l], end = plan.level_start[l + 1];
+        int narrow = (end - begin) < PARALLEL_MIN_LEVEL_WIDTH;
+        int bucket[KERNEL_COUNT + 1] = {0};
+        for (int p = begin; p < end; ++p) { bucket[kernel_of[p] + 1]++; }
+        bucket[0] = begin;
+        for (int k = 0; k < KERNEL_COUNT; ++k) { bucket[k + 1] += bucket[k]; }
+        int kernel_begin[KERNEL_COUNT];
+        memcpy(kernel_begin, bucket, sizeof(kernel_begin));
+        for (int p = begin; p < end; ++p) {
+            int e = plan.order[p];
+            int slot = bucket[kernel_of[p]]++;
+            plan.kernel_from[slot] = plan.from_index[e];
+            plan.kernel_to[slot] = plan.to_index[e];
+            plan.kernel_edge[slot] = e;
+        }
+        for (int k = 0; k < KERNEL_COUNT; ++k) {
+            if (bucket[k] == kernel_begin[k]) { continue; }
+            KernelRun* last = plan.run_count ? &plan.runs[plan.run_count - 1] : NULL;
+            if (last && narrow && previous_narrow && last->kernel == k && last->end == kernel_begin[k]) {
+                last->end = bucket[k];
+            } else {
+                plan.runs[plan.run_count++] = (KernelRun){ k, kernel_begin[k], bucket[k] };
+            }
+        }
+        previous_narrow = narrow;
+    }
+    free(types);
+    free(kernel_of);
+}
+
+void ensure_specialized_plan() {
+    int valid = plan.runs != NULL;
+    for (int i = 0; valid && i < num_nodes; ++i) {
+        valid = plan.kernel_types[i] == nodes[i].value_type;
+    }
+    if (!valid) { specialize_plan(); }
+}
+
+// Runs the specialized edges at positions [begin, end)
+void run_positions(int begin, int end) {
+    int low = 0, high = plan.run_count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (plan.runs[mid].end <= begin) { low = mid + 1; } else { high = mid; }
+    }
+    for (int r = low; r < plan.run_count && plan.runs[r].begin < end; ++r) {
+        int from = plan.runs[r].begin > begin ? plan.runs[r].begin : begin;
+        int to = plan.runs[r].end < end ? plan.runs[r].end : end;
+        if (plan.runs[r].kernel == KERNEL_GENERIC) {
+            for (int p = from; p < to; ++p) {
+                execute_edge(&edges[plan.kernel_edge[p]], &nodes[plan.kernel_from[p]], &nodes[plan.kernel_to[p]]);
+            }
+        } else {
+            run_kernel(plan.runs[r].kernel, plan.kernel_from + from, plan.kernel_to + from, to - from);
+        }
+    }
+}
+
+// --- Parallel Execution ---
+
+void run_edge_items(const int* items, int count) {
+    for (int i = 0; i < count; ++i) {
+        int e = items[i];
+        execute_edge(&edges[e], &nodes[plan.from_index[e]], &nodes[plan.to_index[e]]);
+    }
+}
+
+// Claims chunks of the current level until none are left
+void drain_level_items() {
+    for (;;) {
+        int begin = pool.level_begin + atomic_fetch_add(&pool.next_item, PARALLEL_CHUNK_SIZE);
+        if (begin >= pool.level_end) { break; }
+        int end = begin + PARALLEL_CHUNK_SIZE;
+        if (end > pool.level_end) { end = pool.level_end; }
+        run_positions(begin, end);
+    }
+}
+
+void* pool_worker(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&pool.lock);
+    // Only levels posted after this worker joined are its business
+    int seen_generation = pool.generation;
+    for (;;) {
+        while (!pool.shutting_down && pool.generation == seen_generation) {
+            pthread_cond_wait(&pool.work_ready, &pool.lock);
+        }
+        if (pool.shutting_down) { break; }
+        seen_generation = pool.generation;
+        pthread_mutex_unlock(&pool.lock);
+
+        drain_level_items();
+
+        pthread_mutex_lock(&pool.lock);
+        if (++pool.finished == pool.thread_count) { pthread_cond_signal(&pool.work_done); }
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+void start_thread_pool() {
+    int threads = execution_thread_count > 0 ? execution_thread_count : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) { threads = 1; }
+    pool.threads = (pthread_t*)malloc((threads - 1) * sizeof(pthread_t) + 1);
+    // Workers take the lock before reading any pool state, so holding it
+    // here publishes thread_count and the reset counters before they look.
+    // A restarted pool must not leave a stale generation for them to wake on.
+    pthread_mutex_lock(&pool.lock);
+    pool.thread_count = 0;
+    pool.shutting_down = 0;
+    pool.generation = 0;
+    pool.finished = 0;
+    // The calling thread is the last worker
+    for (int i = 0; i < threads - 1; ++i) {
+        if (pthread_create(&pool.threads[pool.thread_count], NULL, pool_worker, NULL) == 0) {
+            pool.thread_count++;
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+void shutdown_thread_pool() {
+    if (!pool.threads) { return; }
+    pthread_mutex_lock(&pool.lock);
+    pool.shutting_down = 1;
+    pthread_cond_broadcast(&pool.work_ready);
+    pthread_mutex_unlock(&pool.lock);
+    for (int i = 0; i < pool.thread_count; ++i) { pthread_join(pool.threads[i], NULL); }
+    free(pool.threads);
+    pool.threads = NULL;
+    pool.thread_count = 0;
+}
+
+// Runs the specialized positions of one wide level of mutually independent
+// edges, spread over the pool
+void run_level(int begin, int end) {
+    if (!pool.threads) { start_thread_pool(); }
+    if (pool.thread_count == 0) {
+        run_positions(begin, end);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.level_begin = begin;
+    pool.level_end = end;
+    atomic_store(&pool.next_item, 0);
+    pool.finished = 0;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.work_ready);
+    pthread_mutex_unlock(&pool.lock);
+
+    drain_level_items();
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.finished < pool.thread_count) { pthread_cond_wait(&pool.work_done, &pool.lock); }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+// --- Declared Values ---
+
+void release_node_value(Node* node) {
+    if (node->value_type == TYPE_STRING) { string_free(&node->value.string_value); }
+}
+
+void copy_node_value(Node* target, const Node* source) {
+    release_node_value(target);
+    target->value_type = source->value_type;
+    target->value = source->value;
+    if (source->value_type == TYPE_STRING) {
+        string_set(&target->value.string_value, string_chars(&source->value.string_value), source->value.string_value.length);
+    }
+}
+
+// Records the current value of every node added since the last call as its
+// declared value
+void snapshot_declared_values() {
+    if (declared_count == num_nodes) { return; }
+    declared_values = (Node*)realloc(declared_values, num_nodes * sizeof(Node));
+    node_dirty = (unsigned char*)realloc(node_dirty, num_nodes);
+    for (int i = declared_count; i < num_nodes; ++i) {
+        declared_values[i].name = NULL;
+        declared_values[i].value_type = TYPE_INT;
+        copy_node_value(&declared_values[i], &nodes[i]);
+        node_dirty[i] = 0;
+    }
+    declared_count = num_nodes;
+}
+
+// The core execution engine for the graph
+void execute_graph() {
+    ensure_execution_plan();
+    snapshot_declared_values();
+
+    for (int e = 0; plan.order_count < num_edges && e < num_edges; ++e) {
+        if (plan.from_index[e] < 0 || plan.to_index[e] < 0) {
+            fprintf(stderr, "Execution error: Node not found for edge from '%s' to '%s'\n", edges[e].from_node_name, edges[e].to_node_name);
+        }
+    }
+
+    ensure_specialized_plan();
+    // Wide levels go to the pool; stretches of narrow levels run in order
+    for (int l = 0; l < plan.level_count; ) {
+        int next = l + 1;
+        if (plan.level_start[next] - plan.level_start[l] >= PARALLEL_MIN_LEVEL_WIDTH) {
+            run_level(plan.level_start[l], plan.level_start[next]);
+        } else {
+            while (next < plan.level_count && plan.level_start[next + 1] - plan.level_start[next] < PARALLEL_MIN_LEVEL_WIDTH) { next++; }
+            run_positions(plan.level_start[l], plan.level_start[next]);
+        }
+        l = next;
+    }
+    if (passes_since_reset >= 0) { passes_since_reset++; }
+}
+
+// --- Incremental Re-execution ---
+
+void free_declared_values() {
+    for (int i = 0; i < declared_count; ++i) {
+        release_node_value(&declared_values[i]);
+    }
+    free(declared_values);
+    free(node_dirty);
+    free(dirty_nodes);
+    declared_values = NULL;
+    node_dirty = NULL;
+    dirty_nodes = NULL;
+    declared_count = dirty_count = dirty_capacity = 0;
+}
+
+void mark_dirty(int index) {
+    if (node_dirty[index]) { return; }
+    node_dirty[index] = 1;
+    if (dirty_count == dirty_capacity) {
+        dirty_capacity = dirty_capacity ? dirty_capacity * 2 : 64;
+        dirty_nodes = (int*)realloc(dirty_nodes, dirty_capacity * sizeof(int));
+    }
+    dirty_nodes[dirty_count++] = index;
+}
+
+// Groups edge ids by a per-edge node index into a CSR layout
+void group_edges_by_node(const int* node_of_edge, int** start_out, int** items_out) {
+    int* start = (int*)calloc(num_nodes + 1, sizeof(int));
+    int* items = (int*)malloc((num_edges + 1) * sizeof(int));
+    for (int e = 0; e < num_edges; ++e) {
+        if (plan.position[e] >= 0) { start[node_of_edge[e] + 1]++; }
+    }
+    for (int i = 0; i < num_nodes; ++i) { start[i + 1] += start[i]; }
+    int* fill = (int*)malloc((num_nodes + 1) * sizeof(int));
+    memcpy(fill, start, (num_nodes + 1) * sizeof(int));
+    for (int e = 0; e < num_edges; ++e) {
+        if (plan.position[e] >= 0) { items[fill[node_of_edge[e]]++] = e; }
+    }
+    free(fill);
+    *start_out = start;
+    *items_out = items;
+}
+
+void build_dependency_index() {
+    plan.position = (int*)malloc((num_edges + 1) * sizeof(int));
+    plan.last_writer = (int*)malloc((num_nodes + 1) * sizeof(int));
+    for (int e = 0; e < num_edges; ++e) { plan.position[e] = -1; }
+    for (int i = 0; i < plan.order_count; ++i) { plan.position[plan.order[i]] = i; }
+    for (int i = 0; i < num_nodes; ++i) { plan.last_writer[i] = -1; }
+    for (int e = 0; e < num_edges; ++e) {
+        if (plan.position[e] >= 0) { plan.last_writer[plan.to_index[e]] = e; }
+    }
+    group_edges_by_node(plan.from_index, &plan.reads_start, &plan.reads);
+    group_edges_by_node(plan.to_index, &plan.writes_start, &plan.writes);
+}
+
+// Changes a node's declared value and marks it for recompute_dirty()
+Node* begin_set_node(const char* name) {
+    ensure_execution_plan();
+    snapshot_declared_values();
+    Node* node = find_node(name);
+    if (!node) {
+        fprintf(stderr, "Execution error: Cannot set unknown node '%s'\n", name);
+        return NULL;
+    }
+    mark_dirty((int)(node - nodes));
+    return &declared_values[node - nodes];
+}
+
+void set_node_int(const char* name, int value) {
+    Node* declared = begin_set_node(name);
+    if (!declared) { return; }
+    Node updated = { .value_type = TYPE_INT, .value.int_value = value };
+    copy_node_value(declared, &updated);
+}
+
+void set_node_double(const char* name, double value) {
+    Node* declared = begin_set_node(name);
+    if (!declared) { return; }
+    Node updated = { .value_type = TYPE_DOUBLE, .value.double_value = value };
+    copy_node_value(declared, &updated);
+}
+
+void set_node_string(const char* name, const char* value) {
+    Node* declared = begin_set_node(name);
+    if (!declared) { return; }
+    release_node_value(declared);
+    declared->value_type = TYPE_STRING;
+    string_set(&declared->value.string_value, value, (int)strlen(value));
+}
+
+int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Brings every node to the value a single execution from the declared values
+// would give, re-running only the edges that update affected nodes. A node
+// is affected when it was set, when an edge reads an affected node into it,
+// or when an edge into an affected node reads it before it is updated later
+// on (that edge needs its earlier value, not its final one). Falls back to a
+// full evaluation when the current values are not from exactly one pass.
+void recompute_dirty() {
+    ensure_execution_plan();
+    snapshot_declared_values();
+
+    if (passes_since_reset != 1) {
+        for (int i = 0; i < num_nodes; ++i) {
+            copy_node_value(&nodes[i], &declared_values[i]);
+            node_dirty[i] = 0;
+        }
+        dirty_count = 0;
+        passes_since_reset = 0;
+        execute_graph();
+        return;
+    }
+    if (dirty_count == 0) { return; }
+    if (!plan.position) { build_dependency_index(); }
+
+    // dirty_nodes doubles as the worklist while the closure grows
+    for (int next = 0; next < dirty_count; ++next) {
+        int node = dirty_nodes[next];
+        for (int i = plan.reads_start[node]; i < plan.reads_start[node + 1]; ++i) {
+            mark_dirty(plan.to_index[plan.reads[i]]);
+        }
+        for (int i = plan.writes_start[node]; i < plan.writes_start[node + 1]; ++i) {
+            int e = plan.writes[i];
+            int source = plan.from_index[e];
+            if (plan.last_writer[source] > e) { mark_dirty(source); }
+        }
+    }
+
+    // Replay every edge into an affected node in schedule order
+    int replay_count = 0;
+    for (int d = 0; d < dirty_count; ++d) {
+        int node = dirty_nodes[d];
+        replay_count += plan.writes_start[node + 1] - plan.writes_start[node];
+    }
+    int* replay = (int*)malloc((replay_count + 1) * sizeof(int));
+    replay_count = 0;
+    for (int d = 0; d < dirty_count; ++d) {
+        int node = dirty_nodes[d];
+        copy_node_value(&nodes[node], &declared_values[node]);
+        for (int i = plan.writes_start[node]; i < plan.writes_start[node + 1]; ++i) {
+            replay[replay_count++] = plan.position[plan.writes[i]];
+        }
+        node_dirty[node] = 0;
+    }
+    dirty_count = 0;
+    qsort(replay, replay_count, sizeof(int), compare_ints);
+    for (int i = 0; i < replay_count; ++i) { replay[i] = plan.order[replay[i]]; }
+    run_edge_items(replay, replay_count);
+    free(replay);
+}
+
+// --- Benchmarks ---
+
+double seconds_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Tokenizes a generated multi-megabyte program and reports lexer throughput
+void run_lexer_benchmark() {
+    const int node_count = 100000;
+    size_t capacity = (size_t)node_count * 160;
+    char* program = (char*)malloc(capacity);
+    char* out = program;
+    for (int i = 0; i < node_count; ++i) {
+        out += sprintf(out, "node { name: n%d, type: int, value: %d }\n", i, i);
+        out += sprintf(out, "edge { from: n%d, to: n%d, op: '+' } // chain\n", i, (i + 1) % node_count);
+    }
+    double megabytes = (out - program) / (1024.0 * 1024.0);
+
+    double start = seconds_now();
+    tokenize(program);
+    double elapsed = seconds_now() - start;
+
+    printf("Lexer benchmark: %.1f MB, %d tokens in %.3f s (%.0f tokens/sec, %.1f MB/s)\n",
+           megabytes, token_count, elapsed, token_count / elapsed, megabytes / elapsed);
+    free_tokens();
+    free(program);
+}
+
+// Releases the nodes, edges and everything derived from them
+void free_graph() {
+    for (int i = 0; i < num_nodes; ++i) {
+        free(nodes[i].name);
+        release_node_value(&nodes[i]);
+    }
+    free(nodes);
+    for (int i = 0; i < num_edges; ++i) {
+        free(edges[i].from_node_name);
+        free(edges[i].to_node_name);
+        free(edges[i].function_name);
+    }
+    free(edges);
+    nodes = NULL;
+    edges = NULL;
+    num_nodes = num_edges = 0;
+    free_execution_plan();
+    free_declared_values();
+    passes_since_reset = 0;
+}
+
+// Runs a generated all-numeric graph with 1M edges through per-edge dispatch
+// and through the specialized kernels, and reports edges/sec for both
+void run_execution_benchmark() {
+    const int node_count = 100000;
+    const int edge_count = 1000000;
+    const char* ops[] = { "+", "-", "*", "++", "--", "==" };
+    size_t capacity = (size_t)node_count * 64 + (size_t)edge_count * 64;
+    char* program = (char*)malloc(capacity);
+    char* out = program;
+    unsigned int seed = 12345;
+    for (int i = 0; i < node_count; ++i) {
+        if (i % 2) { out += sprintf(out, "node { name: n%d, type: int, value: %d }\n", i, i % 100); }
+        else { out += sprintf(out, "node { name: n%d, type: double, value: %d.5 }\n", i, i % 100); }
+    }
+    for (int i = 0; i < edge_count; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        int from = (seed >> 8) % node_count;
+        seed = seed * 1103515245u + 12345u;
+        int to = (seed >> 8) % node_count;
+        out += sprintf(out, "edge { from: n%d, to: n%d, op: '%s' }\n", from, to, ops[(seed >> 4) % 6]);
+    }
+    tokenize(program);
+    parse_program();
+    free_tokens();
+    free(program);
+
+    // The first pass settles node types so later passes reuse one specialization
+    execution_thread_count = 1;
+    execute_graph();
+    const int passes = 5;
+    double generic_time = 0, kernel_time = 0;
+    for (int pass = 0; pass < passes; ++pass) {
+        double start = seconds_now();
+        run_edge_items(plan.order, plan.order_count);
+        generic_time += seconds_now() - start;
+        start = seconds_now();
+        execute_graph();
+        kernel_time += seconds_now() - start;
+    }
+    printf("Execution benchmark: %d edges, %d levels, %d kernel runs\n", plan.order_count, plan.level_count, plan.run_count);
+    printf("  per-edge dispatch:   %.0f edges/sec\n", (double)plan.order_count * passes / generic_time);
+    printf("  typed kernels:       %.0f edges/sec (%.2fx)\n", (double)plan.order_count * passes / kernel_time, generic_time / kernel_time);
+
+    shutdown_thread_pool();
+    execution_thread_count = 0;
+    double start = seconds_now();
+    for (int pass = 0; pass < passes; ++pass) { execute_graph(); }
+    double parallel_time = seconds_now() - start;
+    printf("  kernels + %d threads: %.0f edges/sec\n", pool.thread_count + 1, (double)plan.order_count * passes / parallel_time);
+    free_graph();
 }
 
 // --- Main function for demonstration ---
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--bench-lexer") == 0) {
+        run_lexer_benchmark();
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-exec") == 0) {
+        run_execution_benchmark();
+        shutdown_thread_pool();
+        return 0;
+    }
+
     const char* sample_code = 
         "// Graph program demonstrating mixed data types\n"
         "node { name: firstName, type: string, value: 'John' }\n"
@@ -471,21 +1419,15 @@ int main() {
     Node* final_number_node = find_node("final_number");
     
     if (final_string_node) {
-        printf("Final value of 'final_string' node is: '%s'\n", final_string_node->value.string_value);
+        printf("Final value of 'final_string' node is: '%s'\n", string_chars(&final_string_node->value.string_value));
     }
     if (final_number_node) {
         printf("Final value of 'final_number' node is: %.2f\n", final_number_node->value.double_value);
     }
 
     // Cleanup
-    for (int i = 0; i < num_nodes; ++i) {
-        free(nodes[i].name);
-        if (nodes[i].value_type == TYPE_STRING && nodes[i].value.string_value) {
-            free(nodes[i].value.string_value);
-        }
-    }
-    free(nodes);
-    for (int i = 0; i < num_edges; ++i) {
-        free(edges[i].from_node_name);
-        free(edges[i].to_node_name);
-        free(edges[i].
+    free_graph();
+    free_tokens();
+    shutdown_thread_pool();
+    return 0;
+}